@@ -0,0 +1,10 @@
+#include "async_search_server.h"
+
+void QueryWatch::Check() const {
+  if (options_.cancellation.IsCancelled()) {
+    throw QueryCancelled("Query was cancelled"s);
+  }
+  if (std::chrono::steady_clock::now() >= options_.deadline) {
+    throw QueryCancelled("Query deadline exceeded"s);
+  }
+}
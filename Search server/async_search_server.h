@@ -0,0 +1,121 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "query_interrupt.h"
+#include "search_server.h"
+#include "thread_pool.h"
+
+class QueryCancelled : public std::runtime_error {
+ public:
+  using std::runtime_error::runtime_error;
+};
+
+// Shared flag that stops every query it was passed to. Copies refer to
+// the same flag.
+class CancellationToken {
+ public:
+  void Cancel() { is_cancelled_->store(true, std::memory_order_relaxed); }
+
+  bool IsCancelled() const {
+    return is_cancelled_->load(std::memory_order_relaxed);
+  }
+
+ private:
+  std::shared_ptr<std::atomic<bool>> is_cancelled_ =
+      std::make_shared<std::atomic<bool>>(false);
+};
+
+struct QueryOptions {
+  std::chrono::steady_clock::time_point deadline =
+      std::chrono::steady_clock::time_point::max();
+  CancellationToken cancellation;
+};
+
+// Checks the cancellation token and the deadline of a query.
+class QueryWatch : public QueryInterrupt {
+ public:
+  explicit QueryWatch(const QueryOptions& options) : options_(options) {}
+
+  void Check() const override;
+
+ private:
+  const QueryOptions& options_;
+};
+
+// Runs BasicSearchServer queries on a thread pool. Results and errors are
+// delivered through the returned future; a query that is cancelled or
+// passes its deadline, before or while it runs, fails with
+// QueryCancelled, and a query submitted while the queue is full fails with
+// std::overflow_error. The server must not be modified while queries are
+// in flight.
+template <typename Config>
+class BasicAsyncSearchServer {
+ public:
+  explicit BasicAsyncSearchServer(
+      const BasicSearchServer<Config>& search_server,
+      size_t thread_count = std::thread::hardware_concurrency(),
+      size_t queue_capacity = 1024)
+      : search_server_(search_server), pool_(thread_count, queue_capacity) {}
+
+  template <typename DocumentPredicate>
+  std::future<std::vector<Document>> FindTopDocuments(
+      std::string raw_query, DocumentPredicate document_predicate,
+      QueryOptions options = {});
+
+  std::future<std::vector<Document>> FindTopDocuments(
+      std::string raw_query, DocumentStatus status,
+      QueryOptions options = {}) {
+    return FindTopDocuments(
+        std::move(raw_query),
+        [status](int /*document_id*/, DocumentStatus document_status,
+                 int /*rating*/) { return document_status == status; },
+        std::move(options));
+  }
+
+  std::future<std::vector<Document>> FindTopDocuments(
+      std::string raw_query, QueryOptions options = {}) {
+    return FindTopDocuments(std::move(raw_query), DocumentStatus::ACTUAL,
+                            std::move(options));
+  }
+
+ private:
+  const BasicSearchServer<Config>& search_server_;
+  ThreadPool pool_;
+};
+
+using AsyncSearchServer = BasicAsyncSearchServer<DefaultSearchServerConfig>;
+
+template <typename Config>
+template <typename DocumentPredicate>
+std::future<std::vector<Document>>
+BasicAsyncSearchServer<Config>::FindTopDocuments(
+    std::string raw_query, DocumentPredicate document_predicate,
+    QueryOptions options) {
+  auto promise = std::make_shared<std::promise<std::vector<Document>>>();
+  auto result = promise->get_future();
+  const bool is_submitted = pool_.TrySubmit(
+      [this, promise, raw_query = std::move(raw_query), document_predicate,
+       options = std::move(options)] {
+        try {
+          const QueryWatch watch(options);
+          watch.Check();
+          promise->set_value(search_server_.FindTopDocuments(
+              raw_query, FieldWeights{}, document_predicate, TfIdfScorer{},
+              &watch));
+        } catch (...) {
+          promise->set_exception(std::current_exception());
+        }
+      });
+  if (!is_submitted) {
+    promise->set_exception(std::make_exception_ptr(
+        std::overflow_error("Search queue is full"s)));
+  }
+  return result;
+}
@@ -1,9 +1,19 @@
 #include "document.h"
 
+#include <numeric>
+
 using namespace std;
 
 std::ostream& operator<<(std::ostream& out, const Document& document) {
   out << "{ document_id = "s << document.id << ", relevance = "s
       << document.relevance << ", rating = "s << document.rating << " }"s;
   return out;
-}
\ No newline at end of file
+}
+
+int ComputeAverageRating(const std::vector<int>& ratings) {
+  if (ratings.empty()) {
+    return 0;
+  }
+  int rating_sum = std::accumulate(begin(ratings), end(ratings), 0);
+  return rating_sum / static_cast<int>(ratings.size());
+}
@@ -1,5 +1,7 @@
 #pragma once
 #include <iostream>
+#include <string_view>
+#include <vector>
 
 struct Document {
   Document() = default;
@@ -10,6 +12,12 @@ struct Document {
   int rating = 0;
 };
 
+// Named part of a document, such as its title or body.
+struct DocumentField {
+  std::string_view name;
+  std::string_view text;
+};
+
 enum class DocumentStatus {
   ACTUAL,
   IRRELEVANT,
@@ -17,4 +25,7 @@ enum class DocumentStatus {
   REMOVED,
 };
 
-std::ostream& operator<<(std::ostream& out, const Document& document);
\ No newline at end of file
+std::ostream& operator<<(std::ostream& out, const Document& document);
+
+// Rounded towards zero; 0 without ratings.
+int ComputeAverageRating(const std::vector<int>& ratings);
\ No newline at end of file
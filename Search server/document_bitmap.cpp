@@ -0,0 +1,209 @@
+#include "document_bitmap.h"
+
+#include <algorithm>
+#include <bitset>
+#include <iterator>
+
+void DocumentBitmap::Add(int document_id) {
+  const auto id = static_cast<uint32_t>(document_id);
+  const auto key = static_cast<uint16_t>(id >> 16);
+  auto it = std::lower_bound(
+      containers_.begin(), containers_.end(), key,
+      [](const Container& container, uint16_t key) {
+        return container.key < key;
+      });
+  if (it == containers_.end() || it->key != key) {
+    it = containers_.insert(it, Container{});
+    it->key = key;
+  }
+  it->Add(static_cast<uint16_t>(id));
+}
+
+bool DocumentBitmap::Contains(int document_id) const {
+  const auto id = static_cast<uint32_t>(document_id);
+  const Container* container = FindContainer(static_cast<uint16_t>(id >> 16));
+  return container && container->Contains(static_cast<uint16_t>(id));
+}
+
+bool DocumentBitmap::Cursor::Contains(int document_id) {
+  const auto id = static_cast<uint32_t>(document_id);
+  const auto key = static_cast<uint16_t>(id >> 16);
+  const auto& containers = bitmap_->containers_;
+  while (container_ < containers.size() && containers[container_].key < key) {
+    ++container_;
+    value_ = 0;
+  }
+  if (container_ == containers.size() || containers[container_].key != key) {
+    return false;
+  }
+  const Container& container = containers[container_];
+  const auto value = static_cast<uint16_t>(id);
+  if (container.IsBitset()) {
+    return container.Contains(value);
+  }
+  const auto& values = container.values;
+  value_ = GallopLowerBound(values.begin() + value_, values.end(), value) -
+           values.begin();
+  return value_ < values.size() && values[value_] == value;
+}
+
+size_t DocumentBitmap::GetCount() const {
+  size_t count = 0;
+  for (const Container& container : containers_) {
+    count += container.count;
+  }
+  return count;
+}
+
+DocumentBitmap& DocumentBitmap::operator&=(const DocumentBitmap& other) {
+  std::vector<Container> result;
+  for (const Container& container : containers_) {
+    const Container* other_container = other.FindContainer(container.key);
+    if (other_container) {
+      Container intersection = Intersect(container, *other_container);
+      if (intersection.count > 0) {
+        result.push_back(std::move(intersection));
+      }
+    }
+  }
+  containers_ = std::move(result);
+  return *this;
+}
+
+DocumentBitmap& DocumentBitmap::operator|=(const DocumentBitmap& other) {
+  std::vector<Container> result;
+  auto lhs = containers_.begin();
+  auto rhs = other.containers_.begin();
+  while (lhs != containers_.end() || rhs != other.containers_.end()) {
+    if (rhs == other.containers_.end() ||
+        (lhs != containers_.end() && lhs->key < rhs->key)) {
+      result.push_back(std::move(*lhs++));
+    } else if (lhs == containers_.end() || rhs->key < lhs->key) {
+      result.push_back(*rhs++);
+    } else {
+      result.push_back(Unite(*lhs++, *rhs++));
+    }
+  }
+  containers_ = std::move(result);
+  return *this;
+}
+
+const DocumentBitmap::Container* DocumentBitmap::FindContainer(
+    uint16_t key) const {
+  const auto it = std::lower_bound(
+      containers_.begin(), containers_.end(), key,
+      [](const Container& container, uint16_t key) {
+        return container.key < key;
+      });
+  return it != containers_.end() && it->key == key ? &*it : nullptr;
+}
+
+DocumentBitmap::Container DocumentBitmap::Intersect(const Container& lhs,
+                                                    const Container& rhs) {
+  Container result;
+  result.key = lhs.key;
+  if (lhs.IsBitset() && rhs.IsBitset()) {
+    result.bits.resize(BITSET_WORDS);
+    for (size_t i = 0; i < BITSET_WORDS; ++i) {
+      result.bits[i] = lhs.bits[i] & rhs.bits[i];
+      result.count += std::bitset<64>(result.bits[i]).count();
+    }
+    result.ToArrayIfSparse();
+  } else if (!lhs.IsBitset() && !rhs.IsBitset()) {
+    std::set_intersection(lhs.values.begin(), lhs.values.end(),
+                          rhs.values.begin(), rhs.values.end(),
+                          std::back_inserter(result.values));
+    result.count = result.values.size();
+  } else {
+    const Container& sparse = lhs.IsBitset() ? rhs : lhs;
+    const Container& dense = lhs.IsBitset() ? lhs : rhs;
+    for (const uint16_t value : sparse.values) {
+      if (dense.Contains(value)) {
+        result.values.push_back(value);
+      }
+    }
+    result.count = result.values.size();
+  }
+  return result;
+}
+
+DocumentBitmap::Container DocumentBitmap::Unite(const Container& lhs,
+                                                const Container& rhs) {
+  Container result;
+  result.key = lhs.key;
+  if (!lhs.IsBitset() && !rhs.IsBitset() &&
+      lhs.count + rhs.count <= ARRAY_LIMIT) {
+    std::set_union(lhs.values.begin(), lhs.values.end(), rhs.values.begin(),
+                   rhs.values.end(), std::back_inserter(result.values));
+    result.count = result.values.size();
+    return result;
+  }
+  Container lhs_bits = lhs;
+  Container rhs_bits = rhs;
+  lhs_bits.ToBitset();
+  rhs_bits.ToBitset();
+  result.bits.resize(BITSET_WORDS);
+  for (size_t i = 0; i < BITSET_WORDS; ++i) {
+    result.bits[i] = lhs_bits.bits[i] | rhs_bits.bits[i];
+    result.count += std::bitset<64>(result.bits[i]).count();
+  }
+  result.ToArrayIfSparse();
+  return result;
+}
+
+bool DocumentBitmap::Container::Contains(uint16_t value) const {
+  if (IsBitset()) {
+    return (bits[value / 64] >> (value % 64)) & 1;
+  }
+  return std::binary_search(values.begin(), values.end(), value);
+}
+
+void DocumentBitmap::Container::Add(uint16_t value) {
+  if (IsBitset()) {
+    uint64_t& word = bits[value / 64];
+    const uint64_t mask = uint64_t{1} << (value % 64);
+    count += !(word & mask);
+    word |= mask;
+    return;
+  }
+  const auto it = std::lower_bound(values.begin(), values.end(), value);
+  if (it != values.end() && *it == value) {
+    return;
+  }
+  values.insert(it, value);
+  ++count;
+  if (count > ARRAY_LIMIT) {
+    ToBitset();
+  }
+}
+
+void DocumentBitmap::Container::ToBitset() {
+  if (IsBitset()) {
+    return;
+  }
+  bits.assign(BITSET_WORDS, 0);
+  for (const uint16_t value : values) {
+    bits[value / 64] |= uint64_t{1} << (value % 64);
+  }
+  values.clear();
+  values.shrink_to_fit();
+}
+
+void DocumentBitmap::Container::ToArrayIfSparse() {
+  if (!IsBitset() || count > ARRAY_LIMIT) {
+    return;
+  }
+  values.clear();
+  values.reserve(count);
+  for (size_t i = 0; i < BITSET_WORDS; ++i) {
+    for (uint64_t word = bits[i]; word != 0; word &= word - 1) {
+      int bit = 0;
+      while (!((word >> bit) & 1)) {
+        ++bit;
+      }
+      values.push_back(static_cast<uint16_t>(i * 64 + bit));
+    }
+  }
+  bits.clear();
+  bits.shrink_to_fit();
+}
@@ -0,0 +1,110 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// First element of the sorted range [first, last) not less than value,
+// found by galloping from first, so it is cheap when close to first.
+template <typename Iterator, typename T>
+Iterator GallopLowerBound(Iterator first, Iterator last, const T& value) {
+  auto size = last - first;
+  decltype(size) step = 1;
+  while (step < size && first[step] < value) {
+    first += step;
+    size -= step;
+    step *= 2;
+  }
+  return std::lower_bound(first, first + std::min(step + 1, size), value);
+}
+
+// Compressed set of document ids in the style of a roaring bitmap: ids are
+// grouped by their upper 16 bits, and each group keeps its lower 16 bits
+// either as a sorted array or, once it holds more than ARRAY_LIMIT ids, as
+// a 65536-bit bitset.
+class DocumentBitmap {
+ public:
+  void Add(int document_id);
+
+  bool Contains(int document_id) const;
+
+  size_t GetCount() const;
+
+  DocumentBitmap& operator&=(const DocumentBitmap& other);
+
+  DocumentBitmap& operator|=(const DocumentBitmap& other);
+
+  // Calls callback(document_id) for every id in increasing order.
+  template <typename Callback>
+  void ForEach(Callback callback) const;
+
+  // Tests a rising sequence of ids, such as a posting list, each test
+  // resuming where the previous one stopped.
+  class Cursor {
+   public:
+    explicit Cursor(const DocumentBitmap& bitmap) : bitmap_(&bitmap) {}
+
+    // document_id must not be less than the one tested before.
+    bool Contains(int document_id);
+
+   private:
+    const DocumentBitmap* bitmap_;
+    size_t container_ = 0;
+    size_t value_ = 0;
+  };
+
+ private:
+  static constexpr size_t ARRAY_LIMIT = 4096;
+  static constexpr size_t BITSET_WORDS = 65536 / 64;
+
+  struct Container {
+    uint16_t key = 0;
+    size_t count = 0;
+    std::vector<uint16_t> values;
+    std::vector<uint64_t> bits;
+
+    bool IsBitset() const { return !bits.empty(); }
+    bool Contains(uint16_t value) const;
+    void Add(uint16_t value);
+    void ToBitset();
+    void ToArrayIfSparse();
+  };
+
+  std::vector<Container> containers_;
+
+  const Container* FindContainer(uint16_t key) const;
+
+  static Container Intersect(const Container& lhs, const Container& rhs);
+
+  static Container Unite(const Container& lhs, const Container& rhs);
+};
+
+template <typename Callback>
+void DocumentBitmap::ForEach(Callback callback) const {
+  for (const Container& container : containers_) {
+    const int high = static_cast<int>(container.key) << 16;
+    if (!container.IsBitset()) {
+      for (const uint16_t value : container.values) {
+        callback(high | value);
+      }
+      continue;
+    }
+    for (size_t i = 0; i < BITSET_WORDS; ++i) {
+      for (uint64_t word = container.bits[i]; word != 0; word &= word - 1) {
+        int bit = 0;
+        while (!((word >> bit) & 1)) {
+          ++bit;
+        }
+        callback(high | static_cast<int>(i * 64 + bit));
+      }
+    }
+  }
+}
+
+inline DocumentBitmap operator&(DocumentBitmap lhs, const DocumentBitmap& rhs) {
+  return lhs &= rhs;
+}
+
+inline DocumentBitmap operator|(DocumentBitmap lhs, const DocumentBitmap& rhs) {
+  return lhs |= rhs;
+}
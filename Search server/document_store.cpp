@@ -0,0 +1,325 @@
+#include "document_store.h"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+
+using namespace std::string_literals;
+
+namespace {
+
+const char MAGIC[4] = {'S', 'S', 'D', 'S'};
+constexpr size_t MIN_MATCH = 4;
+constexpr size_t MAX_OFFSET = 65535;
+constexpr int HASH_BITS = 14;
+
+void AppendLength(std::vector<char>& output, size_t length) {
+  while (length >= 255) {
+    output.push_back(static_cast<char>(255));
+    length -= 255;
+  }
+  output.push_back(static_cast<char>(length));
+}
+
+size_t ReadLength(std::string_view& input, size_t length) {
+  if (length < 15) {
+    return length;
+  }
+  while (true) {
+    if (input.empty()) {
+      throw std::invalid_argument("Compressed block is truncated"s);
+    }
+    const uint8_t byte = static_cast<uint8_t>(input[0]);
+    input.remove_prefix(1);
+    length += byte;
+    if (byte != 255) {
+      return length;
+    }
+  }
+}
+
+// Sequence of literals followed by a copy of match_length bytes from offset
+// bytes back; the last sequence of a block has literals only.
+void AppendSequence(std::vector<char>& output, std::string_view literals,
+                    size_t offset, size_t match_length) {
+  const size_t match_code = match_length == 0 ? 0 : match_length - MIN_MATCH;
+  output.push_back(static_cast<char>((std::min<size_t>(literals.size(), 15)
+                                      << 4) |
+                                     std::min<size_t>(match_code, 15)));
+  if (literals.size() >= 15) {
+    AppendLength(output, literals.size() - 15);
+  }
+  output.insert(output.end(), literals.begin(), literals.end());
+  if (match_length == 0) {
+    return;
+  }
+  output.push_back(static_cast<char>(offset & 0xFF));
+  output.push_back(static_cast<char>(offset >> 8));
+  if (match_code >= 15) {
+    AppendLength(output, match_code - 15);
+  }
+}
+
+void Compress(std::string_view input, std::vector<char>& output) {
+  std::vector<uint32_t> last_positions(size_t{1} << HASH_BITS, UINT32_MAX);
+  size_t anchor = 0;
+  size_t position = 0;
+  while (position + MIN_MATCH <= input.size()) {
+    uint32_t sequence;
+    std::memcpy(&sequence, input.data() + position, sizeof(sequence));
+    const size_t hash = (sequence * 2654435761u) >> (32 - HASH_BITS);
+    const size_t candidate = last_positions[hash];
+    last_positions[hash] = static_cast<uint32_t>(position);
+    if (candidate == UINT32_MAX || position - candidate > MAX_OFFSET ||
+        std::memcmp(input.data() + candidate, input.data() + position,
+                    MIN_MATCH) != 0) {
+      ++position;
+      continue;
+    }
+    size_t match_length = MIN_MATCH;
+    while (position + match_length < input.size() &&
+           input[candidate + match_length] == input[position + match_length]) {
+      ++match_length;
+    }
+    AppendSequence(output, input.substr(anchor, position - anchor),
+                   position - candidate, match_length);
+    position += match_length;
+    anchor = position;
+  }
+  AppendSequence(output, input.substr(anchor), 0, 0);
+}
+
+std::string Decompress(std::string_view input, size_t size) {
+  std::string output;
+  output.reserve(size);
+  while (!input.empty()) {
+    const uint8_t token = static_cast<uint8_t>(input[0]);
+    input.remove_prefix(1);
+    const size_t literal_count = ReadLength(input, token >> 4);
+    if (literal_count > input.size()) {
+      throw std::invalid_argument("Compressed block is truncated"s);
+    }
+    output.append(input.substr(0, literal_count));
+    input.remove_prefix(literal_count);
+    if (input.empty()) {
+      break;
+    }
+    if (input.size() < 2) {
+      throw std::invalid_argument("Compressed block is truncated"s);
+    }
+    const size_t offset = static_cast<uint8_t>(input[0]) |
+                          static_cast<size_t>(static_cast<uint8_t>(input[1]))
+                              << 8;
+    input.remove_prefix(2);
+    const size_t match_length = ReadLength(input, token & 0x0F) + MIN_MATCH;
+    if (offset == 0 || offset > output.size()) {
+      throw std::invalid_argument("Compressed block is corrupted"s);
+    }
+    // Byte by byte, since the copy may overlap the bytes it produces.
+    for (size_t i = 0; i < match_length; ++i) {
+      output.push_back(output[output.size() - offset]);
+    }
+  }
+  if (output.size() != size) {
+    throw std::invalid_argument("Compressed block is corrupted"s);
+  }
+  return output;
+}
+
+template <typename Value>
+void WriteValue(std::ostream& output, Value value) {
+  output.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename Value>
+Value ReadValue(std::string_view& image) {
+  Value value;
+  if (image.size() < sizeof(value)) {
+    throw std::invalid_argument("Document store image is truncated"s);
+  }
+  std::memcpy(&value, image.data(), sizeof(value));
+  image.remove_prefix(sizeof(value));
+  return value;
+}
+
+}  // namespace
+
+DocumentStore DocumentStore::Open(std::string_view image) {
+  if (image.substr(0, sizeof(MAGIC)) !=
+      std::string_view(MAGIC, sizeof(MAGIC))) {
+    throw std::invalid_argument("Not a document store image"s);
+  }
+  image.remove_prefix(sizeof(MAGIC));
+  DocumentStore store;
+  const auto block_count = ReadValue<uint32_t>(image);
+  const auto document_count = ReadValue<uint32_t>(image);
+  // Checked before the tables are allocated, so that a corrupted count
+  // can't make them huge.
+  const uint64_t table_size =
+      (uint64_t{block_count} + 1) * sizeof(uint64_t) +
+      uint64_t{block_count} * sizeof(uint32_t) +
+      uint64_t{document_count} * (sizeof(int32_t) + 3 * sizeof(uint32_t));
+  if (image.size() < table_size) {
+    throw std::invalid_argument("Document store image is truncated"s);
+  }
+  store.block_offsets_.resize(uint64_t{block_count} + 1);
+  for (uint64_t& offset : store.block_offsets_) {
+    offset = ReadValue<uint64_t>(image);
+  }
+  // Every compressed block has at least its final token.
+  if (store.block_offsets_.front() != 0 ||
+      std::adjacent_find(store.block_offsets_.begin(),
+                         store.block_offsets_.end(),
+                         std::greater_equal<>()) !=
+          store.block_offsets_.end()) {
+    throw std::invalid_argument("Document store image is corrupted"s);
+  }
+  store.block_sizes_.resize(block_count);
+  for (uint32_t& size : store.block_sizes_) {
+    size = ReadValue<uint32_t>(image);
+  }
+  for (uint32_t i = 0; i < document_count; ++i) {
+    const auto document_id = ReadValue<int32_t>(image);
+    Location location;
+    location.block = ReadValue<uint32_t>(image);
+    location.offset = ReadValue<uint32_t>(image);
+    location.size = ReadValue<uint32_t>(image);
+    if (location.block >= block_count ||
+        location.offset + uint64_t{location.size} >
+            store.block_sizes_[location.block]) {
+      throw std::invalid_argument("Document store image is corrupted"s);
+    }
+    if (!store.locations_.emplace(document_id, location).second) {
+      throw std::invalid_argument("Document store image is corrupted"s);
+    }
+  }
+  if (image.size() < store.block_offsets_.back()) {
+    throw std::invalid_argument("Document store image is truncated"s);
+  }
+  if (image.size() > store.block_offsets_.back()) {
+    throw std::invalid_argument("Document store image is corrupted"s);
+  }
+  store.external_blocks_ = image.data();
+  return store;
+}
+
+void DocumentStore::Add(int document_id, std::string_view text) {
+  if (external_blocks_) {
+    throw std::logic_error("Document store is read-only"s);
+  }
+  if (locations_.count(document_id) > 0) {
+    throw std::invalid_argument("Invalid document_id"s);
+  }
+  if (!open_block_.empty() && open_block_.size() + text.size() > BLOCK_SIZE) {
+    SealBlock();
+  }
+  locations_.emplace(document_id,
+                     Location{static_cast<uint32_t>(block_sizes_.size()),
+                              static_cast<uint32_t>(open_block_.size()),
+                              static_cast<uint32_t>(text.size())});
+  open_block_.append(text);
+}
+
+bool DocumentStore::Contains(int document_id) const {
+  return locations_.count(document_id) > 0;
+}
+
+std::string DocumentStore::Get(int document_id) const {
+  const Location& location = GetLocation(document_id);
+  if (location.block == block_sizes_.size()) {
+    return open_block_.substr(location.offset, location.size);
+  }
+  return ReadBlock(location.block).substr(location.offset, location.size);
+}
+
+std::vector<std::string> DocumentStore::Get(
+    const std::vector<int>& document_ids) const {
+  std::vector<const Location*> locations;
+  locations.reserve(document_ids.size());
+  for (const int document_id : document_ids) {
+    locations.push_back(&GetLocation(document_id));
+  }
+  std::vector<size_t> order(document_ids.size());
+  for (size_t i = 0; i < order.size(); ++i) {
+    order[i] = i;
+  }
+  std::sort(order.begin(), order.end(), [&locations](size_t lhs, size_t rhs) {
+    return locations[lhs]->block < locations[rhs]->block;
+  });
+  std::vector<std::string> texts(document_ids.size());
+  std::string block_text;
+  uint32_t current_block = UINT32_MAX;
+  for (const size_t i : order) {
+    const Location& location = *locations[i];
+    if (location.block == block_sizes_.size()) {
+      texts[i] = open_block_.substr(location.offset, location.size);
+      continue;
+    }
+    if (location.block != current_block) {
+      block_text = ReadBlock(location.block);
+      current_block = location.block;
+    }
+    texts[i] = block_text.substr(location.offset, location.size);
+  }
+  return texts;
+}
+
+void DocumentStore::Save(std::ostream& output) const {
+  std::vector<char> last_block;
+  if (!open_block_.empty()) {
+    Compress(open_block_, last_block);
+  }
+  const uint32_t block_count = static_cast<uint32_t>(
+      block_sizes_.size() + (open_block_.empty() ? 0 : 1));
+  output.write(MAGIC, sizeof(MAGIC));
+  WriteValue(output, block_count);
+  WriteValue(output, static_cast<uint32_t>(locations_.size()));
+  for (const uint64_t offset : block_offsets_) {
+    WriteValue(output, offset);
+  }
+  if (!open_block_.empty()) {
+    WriteValue(output, block_offsets_.back() + last_block.size());
+  }
+  for (const uint32_t size : block_sizes_) {
+    WriteValue(output, size);
+  }
+  if (!open_block_.empty()) {
+    WriteValue(output, static_cast<uint32_t>(open_block_.size()));
+  }
+  for (const auto& [document_id, location] : locations_) {
+    WriteValue(output, static_cast<int32_t>(document_id));
+    WriteValue(output, location.block);
+    WriteValue(output, location.offset);
+    WriteValue(output, location.size);
+  }
+  const char* blocks = external_blocks_ ? external_blocks_ : compressed_.data();
+  output.write(blocks, static_cast<std::streamsize>(block_offsets_.back()));
+  output.write(last_block.data(),
+               static_cast<std::streamsize>(last_block.size()));
+}
+
+const DocumentStore::Location& DocumentStore::GetLocation(
+    int document_id) const {
+  const auto it = locations_.find(document_id);
+  if (it == locations_.end()) {
+    throw std::out_of_range("No stored text for document "s +
+                            std::to_string(document_id));
+  }
+  return it->second;
+}
+
+void DocumentStore::SealBlock() {
+  Compress(open_block_, compressed_);
+  block_offsets_.push_back(compressed_.size());
+  block_sizes_.push_back(static_cast<uint32_t>(open_block_.size()));
+  open_block_.clear();
+}
+
+std::string DocumentStore::ReadBlock(uint32_t block) const {
+  const char* blocks = external_blocks_ ? external_blocks_ : compressed_.data();
+  const uint64_t begin = block_offsets_[block];
+  return Decompress(
+      std::string_view(blocks + begin, block_offsets_[block + 1] - begin),
+      block_sizes_[block]);
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Document texts keyed by id, concatenated into blocks of about BLOCK_SIZE
+// bytes that are LZ77 compressed once full. The last block stays
+// uncompressed until more text arrives or the store is saved.
+class DocumentStore {
+ public:
+  static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+  DocumentStore() = default;
+
+  // Reads a store written by Save. The compressed blocks are used in place,
+  // so image can point into a memory-mapped file and must outlive the
+  // result, which is read-only.
+  static DocumentStore Open(std::string_view image);
+
+  void Add(int document_id, std::string_view text);
+
+  bool Contains(int document_id) const;
+
+  std::string Get(int document_id) const;
+
+  // Decompresses each block at most once, so fetching the texts of found
+  // documents costs one block per neighbourhood of ids instead of one per
+  // document.
+  std::vector<std::string> Get(const std::vector<int>& document_ids) const;
+
+  void Save(std::ostream& output) const;
+
+ private:
+  struct Location {
+    uint32_t block;
+    uint32_t offset;
+    uint32_t size;
+  };
+
+  std::vector<char> compressed_;
+  const char* external_blocks_ = nullptr;
+  // Offsets of the compressed blocks, plus the end of the last one.
+  std::vector<uint64_t> block_offsets_ = {0};
+  std::vector<uint32_t> block_sizes_;
+  std::string open_block_;
+  std::map<int, Location> locations_;
+
+  const Location& GetLocation(int document_id) const;
+
+  void SealBlock();
+
+  std::string ReadBlock(uint32_t block) const;
+};
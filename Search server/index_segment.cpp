@@ -0,0 +1,142 @@
+#include "index_segment.h"
+
+#include <algorithm>
+#include <numeric>
+
+void IndexSegment::Builder::AddDocument(
+    const DocumentData& document, const std::vector<std::string_view>& words) {
+  const auto document_index = static_cast<uint32_t>(documents_.size());
+  const double inv_word_count = 1.0 / words.size();
+  for (const std::string_view word : words) {
+    auto word_it = word_freqs_.find(word);
+    if (word_it == word_freqs_.end()) {
+      word_it =
+          word_freqs_.emplace(std::string(word), std::vector<WordFreq>{}).first;
+    }
+    auto& freqs = word_it->second;
+    if (freqs.empty() || freqs.back().document_index != document_index) {
+      freqs.push_back({document_index, 0.0});
+    }
+    freqs.back().term_freq += inv_word_count;
+  }
+  documents_.push_back(document);
+}
+
+bool IndexSegment::Builder::ContainsDocument(int document_id) const {
+  return std::any_of(documents_.begin(), documents_.end(),
+                     [document_id](const DocumentData& document) {
+                       return document.id == document_id;
+                     });
+}
+
+IndexSegment IndexSegment::Builder::Build() {
+  std::map<std::string_view, std::vector<Posting>> word_postings;
+  for (const auto& [word, freqs] : word_freqs_) {
+    auto& postings = word_postings[word];
+    for (const WordFreq& freq : freqs) {
+      postings.push_back({freq.document_index, freq.term_freq});
+    }
+  }
+  IndexSegment segment;
+  segment.Assign(std::move(documents_), word_postings);
+  documents_.clear();
+  word_freqs_.clear();
+  return segment;
+}
+
+IndexSegment IndexSegment::Merge(
+    const std::vector<const IndexSegment*>& segments,
+    const std::unordered_set<int>& deleted,
+    std::vector<int>& applied_deletions) {
+  std::vector<DocumentData> documents;
+  // Index of each input document in documents, or UINT32_MAX if deleted.
+  std::vector<std::vector<uint32_t>> document_indexes(segments.size());
+  for (size_t s = 0; s < segments.size(); ++s) {
+    for (const DocumentData& document : segments[s]->documents_) {
+      if (deleted.count(document.id)) {
+        applied_deletions.push_back(document.id);
+        document_indexes[s].push_back(UINT32_MAX);
+      } else {
+        document_indexes[s].push_back(static_cast<uint32_t>(documents.size()));
+        documents.push_back(document);
+      }
+    }
+  }
+  std::map<std::string_view, std::vector<Posting>> word_postings;
+  for (size_t s = 0; s < segments.size(); ++s) {
+    const IndexSegment& segment = *segments[s];
+    for (size_t w = 0; w + 1 < segment.word_offsets_.size(); ++w) {
+      std::vector<Posting>* postings = nullptr;
+      for (uint32_t p = segment.posting_offsets_[w];
+           p < segment.posting_offsets_[w + 1]; ++p) {
+        const Posting& posting = segment.postings_[p];
+        const uint32_t document_index =
+            document_indexes[s][posting.document_index];
+        if (document_index == UINT32_MAX) {
+          continue;
+        }
+        if (!postings) {
+          postings = &word_postings[segment.GetWord(w)];
+        }
+        postings->push_back({document_index, posting.term_freq});
+      }
+    }
+  }
+  IndexSegment merged;
+  merged.Assign(std::move(documents), word_postings);
+  return merged;
+}
+
+IndexSegment::PostingRange IndexSegment::FindPostings(
+    std::string_view word) const {
+  size_t first = 0;
+  size_t last = word_offsets_.empty() ? 0 : word_offsets_.size() - 1;
+  while (first < last) {
+    const size_t middle = first + (last - first) / 2;
+    if (GetWord(middle) < word) {
+      first = middle + 1;
+    } else {
+      last = middle;
+    }
+  }
+  if (first + 1 >= word_offsets_.size() || GetWord(first) != word) {
+    return {nullptr, nullptr};
+  }
+  return {postings_.data() + posting_offsets_[first],
+          postings_.data() + posting_offsets_[first + 1]};
+}
+
+template <typename WordPostings>
+void IndexSegment::Assign(std::vector<DocumentData> documents,
+                          const WordPostings& word_postings) {
+  std::vector<uint32_t> order(documents.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(),
+            [&documents](uint32_t lhs, uint32_t rhs) {
+              return documents[lhs].id < documents[rhs].id;
+            });
+  std::vector<uint32_t> new_index(documents.size());
+  documents_.reserve(documents.size());
+  for (uint32_t i = 0; i < order.size(); ++i) {
+    new_index[order[i]] = i;
+    documents_.push_back(documents[order[i]]);
+  }
+  word_offsets_.push_back(0);
+  posting_offsets_.push_back(0);
+  for (const auto& [word, postings] : word_postings) {
+    const size_t first_posting = postings_.size();
+    for (const Posting& posting : postings) {
+      postings_.push_back(
+          {new_index[posting.document_index], posting.term_freq});
+    }
+    std::sort(postings_.begin() + first_posting, postings_.end(),
+              [](const Posting& lhs, const Posting& rhs) {
+                return lhs.document_index < rhs.document_index;
+              });
+    words_.append(word);
+    word_offsets_.push_back(static_cast<uint32_t>(words_.size()));
+    posting_offsets_.push_back(static_cast<uint32_t>(postings_.size()));
+  }
+  words_.shrink_to_fit();
+  postings_.shrink_to_fit();
+}
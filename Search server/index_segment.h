@@ -0,0 +1,83 @@
+#pragma once
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "document.h"
+
+// Immutable inverted index over a group of documents. Words are kept in
+// one sorted character buffer and postings in one contiguous array, with
+// each word's postings ordered by document id.
+class IndexSegment {
+ public:
+  struct DocumentData {
+    int id;
+    int rating;
+    DocumentStatus status;
+    int word_count;
+  };
+
+  struct Posting {
+    uint32_t document_index;
+    double term_freq;
+  };
+
+  using PostingRange = std::pair<const Posting*, const Posting*>;
+
+  class Builder {
+   public:
+    void AddDocument(const DocumentData& document,
+                     const std::vector<std::string_view>& words);
+
+    bool ContainsDocument(int document_id) const;
+
+    size_t GetDocumentCount() const { return documents_.size(); }
+
+    IndexSegment Build();
+
+   private:
+    struct WordFreq {
+      uint32_t document_index;
+      double term_freq;
+    };
+
+    std::vector<DocumentData> documents_;
+    std::map<std::string, std::vector<WordFreq>, std::less<>> word_freqs_;
+  };
+
+  // Combines segments into one, leaving out documents listed in deleted.
+  // Ids of the documents it left out are appended to applied_deletions.
+  static IndexSegment Merge(const std::vector<const IndexSegment*>& segments,
+                            const std::unordered_set<int>& deleted,
+                            std::vector<int>& applied_deletions);
+
+  size_t GetDocumentCount() const { return documents_.size(); }
+
+  const DocumentData& GetDocument(uint32_t index) const {
+    return documents_[index];
+  }
+
+  PostingRange FindPostings(std::string_view word) const;
+
+ private:
+  std::vector<DocumentData> documents_;
+  std::string words_;
+  std::vector<uint32_t> word_offsets_;
+  std::vector<uint32_t> posting_offsets_;
+  std::vector<Posting> postings_;
+
+  std::string_view GetWord(size_t index) const {
+    return std::string_view(words_).substr(
+        word_offsets_[index], word_offsets_[index + 1] - word_offsets_[index]);
+  }
+
+  // Stores documents sorted by id and renumbers the postings, which refer
+  // to positions in the unsorted documents, to match.
+  template <typename WordPostings>
+  void Assign(std::vector<DocumentData> documents,
+              const WordPostings& word_postings);
+};
@@ -1,13 +1,1210 @@
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <future>
+#include <iostream>
+#include <iterator>
+#include <list>
+#include <memory_resource>
+#include <new>
+#include <optional>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "async_search_server.h"
 #include "document.h"
+#include "document_bitmap.h"
+#include "document_store.h"
 #include "paginator.h"
+#include "query_arena.h"
+#include "query_interrupt.h"
 #include "read_input_functions.h"
 #include "request_queue.h"
 #include "search_server.h"
+#include "segmented_search_server.h"
 #include "string_processing.h"
+#include "term_dictionary.h"
+#include "thread_pool.h"
+#include "tokenizer.h"
 
 using namespace std;
 
+// Bytes allocated by the program, so tests can check that the memory of a
+// query doesn't grow with the number of documents it reads.
+atomic<size_t> allocated_bytes = 0;
+
+namespace {
+
+void* CountedAllocate(size_t size) {
+  allocated_bytes.fetch_add(size, memory_order_relaxed);
+  if (void* data = malloc(size ? size : 1)) {
+    return data;
+  }
+  throw bad_alloc();
+}
+
+}  // namespace
+
+void* operator new(size_t size) { return CountedAllocate(size); }
+
+void operator delete(void* data) noexcept { free(data); }
+
+void operator delete(void* data, size_t) noexcept { free(data); }
+
+void TestQueryArena() {
+  cout << "TestQueryArena: \t\t\t"s;
+  {
+    pmr::memory_resource* resource = nullptr;
+    void* first_block = nullptr;
+    {
+      QueryArena arena;
+      resource = arena.Resource();
+      first_block = resource->allocate(100);
+    }
+    // The next query on the thread starts over in the same buffer.
+    QueryArena arena;
+    assert(arena.Resource() == resource);
+    assert(arena.Resource()->allocate(100) == first_block);
+    {
+      QueryArena nested;
+      assert(nested.Resource() != resource);
+    }
+    assert(arena.Resource()->allocate(100) != first_block);
+  }
+  {
+    SearchServer search_server("and"s);
+    search_server.AddDocument(1, "curly cat"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(2, "curly dog"s, DocumentStatus::ACTUAL, {2});
+    // A predicate running its own query gets a nested arena, so the outer
+    // query's words stay valid.
+    const auto documents = search_server.FindTopDocuments(
+        "curly"s, [&search_server](int document_id, DocumentStatus, int) {
+          return !search_server.FindTopDocuments("cat"s).empty() &&
+                 document_id == 2;
+        });
+    assert(documents.size() == 1 && documents[0].id == 2);
+  }
+  {
+    // Once the thread's buffer is warmed up, the vector a query returns is
+    // all it allocates on the heap.
+    SearchServer search_server("and"s);
+    for (int id = 0; id < 1000; ++id) {
+      search_server.AddDocument(id, id % 3 ? "curly cat"s : "curly dog"s,
+                                DocumentStatus::ACTUAL, {id});
+    }
+    const string query = "curly cat -dog"s;
+    search_server.FindTopDocuments(query);
+    const size_t before = allocated_bytes;
+    const auto documents = search_server.FindTopDocuments(query);
+    assert(documents.size() == 5);
+    assert(allocated_bytes - before == documents.size() * sizeof(Document));
+  }
+  cout << "OK!"s << endl;
+}
+
+void TestLoadDocuments() {
+  cout << "TestLoadDocuments: \t\t"s;
+  {
+    SearchServer search_server(""s);
+    istringstream input(
+        "1 ACTUAL 7,2,7 curly cat\r\n\n  \n2 1 - big dog\n3 BANNED 5 tail"s);
+    assert(LoadDocuments(input, search_server) == 3);
+    assert(search_server.GetDocumentCount() == 3);
+    assert(get<1>(search_server.MatchDocument("dog"s, 2)) ==
+           DocumentStatus::IRRELEVANT);
+    const auto documents =
+        search_server.FindTopDocuments("tail"s, DocumentStatus::BANNED);
+    assert(documents.size() == 1 && documents[0].rating == 5);
+  }
+  {
+    // Spans several blocks, with lines cut at block boundaries.
+    string text;
+    for (int i = 0; i < 100000; ++i) {
+      text += to_string(i) + " ACTUAL "s + to_string(i % 10) +
+              " document number "s + to_string(i) + "\n"s;
+    }
+    SearchServer search_server(""s);
+    istringstream input(text);
+    assert(LoadDocuments(input, search_server, 1) == 100000);
+    assert(search_server.FindTopDocuments("99999"s)[0].id == 99999);
+  }
+  {
+    SearchServer search_server(""s);
+    istringstream input("1 ACTUAL - cat\n2 ACTUAL - dog\n3 ACTUAL x bird\n"
+                        "4 ACTUAL - fish\n"s);
+    try {
+      LoadDocuments(input, search_server);
+      assert(false);
+    } catch (const invalid_argument& e) {
+      assert(e.what() == "Invalid document record at line 3"s);
+    }
+    assert(search_server.GetDocumentCount() == 2);
+  }
+  cout << "OK!"s << endl;
+}
+
+void TestPaginator() {
+  cout << "TestPaginator: \t\t\t"s;
+  {
+    const vector<int> values = {1, 2, 3, 4, 5, 6, 7};
+    const auto pages = Paginate(values, 3);
+    assert(pages.size() == 3);
+    assert(distance(pages.begin(), pages.end()) == 3);
+    assert(pages[0].size() == 3 && *pages[0].begin() == 1);
+    assert(pages[2].size() == 1 && *pages[2].begin() == 7);
+    assert(pages[2].end() == values.end());
+    auto it = pages.begin();
+    assert((it++)->begin() == values.begin());
+    assert(it->begin() == values.begin() + 3);
+    Paginator<vector<int>::const_iterator>::PageIterator unset;
+    unset = it;
+    assert(unset == it);
+  }
+  {
+    const list<int> values = {1, 2, 3, 4};
+    const auto pages = Paginate(values, 2);
+    assert(pages.size() == 2);
+    int sum = 0;
+    size_t page_count = 0;
+    for (const auto& page : pages) {
+      assert(page.size() == 2);
+      for (const int value : page) {
+        sum += value;
+      }
+      ++page_count;
+    }
+    assert(page_count == 2 && sum == 10);
+  }
+  {
+    const vector<int> values;
+    const auto pages = Paginate(values, 2);
+    assert(pages.size() == 0 && pages.begin() == pages.end());
+    try {
+      Paginate(values, 0);
+      assert(false);
+    } catch (const invalid_argument&) {
+    }
+  }
+  cout << "OK!"s << endl;
+}
+
+vector<int> GetIds(const vector<Document>& documents) {
+  vector<int> ids;
+  for (const Document& document : documents) {
+    ids.push_back(document.id);
+  }
+  return ids;
+}
+
+// Counts matched query words.
+struct MatchCountScorer {
+  int PrepareTerm(const CollectionStats&, size_t) const { return 1; }
+
+  double Score(int term, double, int) const { return term; }
+};
+
+void TestScorers() {
+  cout << "TestScorers: \t\t\t"s;
+  SearchServer search_server(""s);
+  search_server.AddDocument(1, "cat cat cat dog"s, DocumentStatus::ACTUAL,
+                            {1});
+  search_server.AddDocument(2, "cat bird bird bird"s, DocumentStatus::ACTUAL,
+                            {2});
+  search_server.AddDocument(3, "cat dog"s, DocumentStatus::ACTUAL, {3});
+  search_server.AddDocument(4, "fish"s, DocumentStatus::ACTUAL, {4});
+  const auto tf_idf = search_server.FindTopDocuments(
+      "cat"s, DocumentStatus::ACTUAL, TfIdfScorer{});
+  assert((GetIds(tf_idf) == vector<int>{1, 3, 2}));
+  assert(tf_idf[0].relevance == search_server.FindTopDocuments("cat"s)[0]
+                                    .relevance);
+  // Rarity only: the matches tie and are ordered by rating.
+  const auto idf = search_server.FindTopDocuments(
+      "cat"s, DocumentStatus::ACTUAL, IdfScorer{});
+  assert((GetIds(idf) == vector<int>{3, 2, 1}));
+  assert(idf[0].relevance == idf[2].relevance);
+  // Three occurrences beat one, and one in a short document beats one in
+  // a long document.
+  const auto bm25 = search_server.FindTopDocuments(
+      "cat"s, DocumentStatus::ACTUAL, Bm25Scorer{});
+  assert((GetIds(bm25) == vector<int>{1, 3, 2}));
+  assert(bm25[1].relevance > bm25[2].relevance);
+  // Without length normalization the single matches tie.
+  const auto bm25_flat = search_server.FindTopDocuments(
+      "cat"s, DocumentStatus::ACTUAL, Bm25Scorer{1.2, 0.0});
+  assert((GetIds(bm25_flat) == vector<int>{1, 3, 2}));
+  assert(abs(bm25_flat[1].relevance - bm25_flat[2].relevance) < 1e-6);
+  const auto counted = search_server.FindTopDocuments(
+      "cat dog fish"s, DocumentStatus::ACTUAL, MatchCountScorer{});
+  assert((GetIds(counted) == vector<int>{3, 1, 4, 2}));
+  assert(counted[0].relevance == 2.0 && counted[3].relevance == 1.0);
+  cout << "OK!"s << endl;
+}
+
+void AddPhraseDocuments(SearchServerBase& search_server) {
+  search_server.AddDocument(1, "curly cat with a fluffy tail"s,
+                            DocumentStatus::ACTUAL, {1});
+  search_server.AddDocument(2, "cat curly"s, DocumentStatus::ACTUAL, {2});
+  search_server.AddDocument(3, "curly fluffy cat"s, DocumentStatus::ACTUAL,
+                            {3});
+}
+
+void TestPhraseQueries() {
+  cout << "TestPhraseQueries: \t\t"s;
+  {
+    SearchServer search_server("a with"s, IndexMode::POSITIONS);
+    AddPhraseDocuments(search_server);
+    assert((GetIds(search_server.FindTopDocuments("\"curly cat\""s)) ==
+            vector<int>{1}));
+    assert((GetIds(search_server.FindTopDocuments("\"cat curly\""s)) ==
+            vector<int>{2}));
+    // Stop words keep their place in the phrase.
+    assert((GetIds(search_server.FindTopDocuments("\"cat a fluffy\""s)) ==
+            vector<int>{}));
+    assert((GetIds(search_server.FindTopDocuments(
+                "\"cat with a fluffy\""s)) == vector<int>{1}));
+    assert(get<0>(search_server.MatchDocument("\"curly cat\""s, 3)).empty());
+    assert(get<0>(search_server.MatchDocument("\"curly cat\""s, 1)).size() ==
+           2);
+  }
+  {
+    SearchServer search_server(""s, IndexMode::POSITIONS);
+    AddPhraseDocuments(search_server);
+    const auto plain = search_server.FindTopDocuments("curly cat"s);
+    search_server.SetProximityWeight(1.0);
+    const auto boosted = search_server.FindTopDocuments("curly cat"s);
+    // Adjacent words add the whole weight, words two apart half of it.
+    assert((GetIds(boosted) == vector<int>{2, 1, 3}));
+    for (const Document& document : boosted) {
+      const double boost = document.id == 3 ? 0.5 : 1.0;
+      const auto it = find_if(plain.begin(), plain.end(),
+                              [&document](const Document& other) {
+                                return other.id == document.id;
+                              });
+      assert(abs(document.relevance - it->relevance - boost) < 1e-6);
+    }
+  }
+  {
+    SearchServer search_server(""s);
+    AddPhraseDocuments(search_server);
+    try {
+      search_server.FindTopDocuments("\"curly cat\""s);
+      assert(false);
+    } catch (const invalid_argument&) {
+    }
+  }
+  {
+    static_assert(is_copy_assignable_v<SearchServer>);
+    optional<SearchServer> source(in_place, ""s, IndexMode::POSITIONS);
+    AddPhraseDocuments(*source);
+    SearchServer copy(*source);
+    SearchServer assigned(""s);
+    assigned = *source;
+    source.reset();
+    assert((GetIds(copy.FindTopDocuments("\"curly cat\""s)) ==
+            vector<int>{1}));
+    assert((GetIds(assigned.FindTopDocuments("\"cat curly\""s)) ==
+            vector<int>{2}));
+    copy.AddDocument(4, "curly cat"s, DocumentStatus::ACTUAL, {4});
+    assert((GetIds(copy.FindTopDocuments("\"curly cat\""s)) ==
+            vector<int>{4, 1}));
+  }
+  cout << "OK!"s << endl;
+}
+
+void TestPrefixQueries() {
+  cout << "TestPrefixQueries: \t\t"s;
+  {
+    SearchServer search_server(""s);
+    search_server.AddDocument(1, "cat"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(2, "catalog dog"s, DocumentStatus::ACTUAL, {2});
+    search_server.AddDocument(3, "category"s, DocumentStatus::ACTUAL, {3});
+    search_server.AddDocument(4, "cast dog"s, DocumentStatus::ACTUAL, {4});
+    assert((GetIds(search_server.FindTopDocuments("cat*"s)) ==
+            vector<int>{3, 1, 2}));
+    assert((GetIds(search_server.FindTopDocuments("dog -cat*"s)) ==
+            vector<int>{4}));
+    assert((get<0>(search_server.MatchDocument("cat*"s, 2)) ==
+            vector<string>{"catalog"s}));
+    assert(search_server.FindTopDocuments("cats*"s).empty());
+    // New words reach the dictionary, which is rebuilt on demand.
+    search_server.AddDocument(5, "catnip"s, DocumentStatus::ACTUAL, {5});
+    assert((GetIds(search_server.FindTopDocuments("catn*"s)) ==
+            vector<int>{5}));
+    SearchServer copy(search_server);
+    assert((GetIds(copy.FindTopDocuments("cas*"s)) == vector<int>{4}));
+    // The dictionary moves with the index, and the source forgets it.
+    optional<SearchServer> moved(std::move(search_server));
+    assert((GetIds(moved->FindTopDocuments("catn*"s)) == vector<int>{5}));
+    moved.reset();
+    assert(search_server.FindTopDocuments("cat*"s).empty());
+    optional<SearchServer> assigned(in_place, ""s);
+    *assigned = std::move(copy);
+    assert((GetIds(assigned->FindTopDocuments("cas*"s)) == vector<int>{4}));
+    assigned.reset();
+    assert(copy.FindTopDocuments("cas*"s).empty());
+  }
+  {
+    // A prefix expands to at most 64 words, the first ones in order.
+    SearchServer search_server(""s);
+    for (int i = 0; i < 100; ++i) {
+      search_server.AddDocument(i, "w"s + to_string(100 + i),
+                                DocumentStatus::ACTUAL, {});
+    }
+    assert(!get<0>(search_server.MatchDocument("w*"s, 63)).empty());
+    assert(get<0>(search_server.MatchDocument("w*"s, 64)).empty());
+  }
+  cout << "OK!"s << endl;
+}
+
+// Counts the bytes allocated through it.
+class CountingResource : public pmr::memory_resource {
+ public:
+  size_t GetAllocatedBytes() const { return allocated_bytes_; }
+
+ private:
+  size_t allocated_bytes_ = 0;
+
+  void* do_allocate(size_t bytes, size_t alignment) override {
+    allocated_bytes_ += bytes;
+    return pmr::new_delete_resource()->allocate(bytes, alignment);
+  }
+
+  void do_deallocate(void* data, size_t bytes, size_t alignment) override {
+    pmr::new_delete_resource()->deallocate(data, bytes, alignment);
+  }
+
+  bool do_is_equal(const memory_resource& other) const noexcept override {
+    return this == &other;
+  }
+};
+
+void TestFuzzyQueries() {
+  cout << "TestFuzzyQueries: \t\t"s;
+  SearchServer search_server(""s);
+  search_server.AddDocument(1, "fluffy cat"s, DocumentStatus::ACTUAL, {1});
+  search_server.AddDocument(2, "curly dog"s, DocumentStatus::ACTUAL, {2});
+  search_server.AddDocument(3, "пушистая кошка"s, DocumentStatus::ACTUAL,
+                            {3});
+  search_server.AddDocument(4, "ко"s, DocumentStatus::ACTUAL, {4});
+  assert(search_server.FindTopDocuments("flufy"s).empty());
+  search_server.SetFuzzyMatching(1, 0.5);
+  const auto exact = search_server.FindTopDocuments("fluffy"s);
+  const auto corrected = search_server.FindTopDocuments("flufy"s);
+  assert((GetIds(corrected) == vector<int>{1}));
+  assert(abs(corrected[0].relevance - exact[0].relevance * 0.5) < 1e-6);
+  assert((get<0>(search_server.MatchDocument("flufy"s, 1)) ==
+          vector<string>{"fluffy"s}));
+  // Two edits, but cat is too short for more than one.
+  assert(search_server.FindTopDocuments("cta"s).empty());
+  // Edits are counted in characters, not bytes.
+  const auto cyrillic_exact = search_server.FindTopDocuments("кошка"s);
+  const auto cyrillic = search_server.FindTopDocuments("кшка"s);
+  assert((GetIds(cyrillic) == vector<int>{3}));
+  assert(abs(cyrillic[0].relevance - cyrillic_exact[0].relevance * 0.5) <
+         1e-6);
+  assert((GetIds(search_server.FindTopDocuments("пушыстая"s)) ==
+          vector<int>{3}));
+  assert(search_server.FindTopDocuments("ка"s).empty());
+  search_server.SetFuzzyMatching(2, 0.5);
+  assert((GetIds(search_server.FindTopDocuments("flaffyy"s)) ==
+          vector<int>{1}));
+  try {
+    search_server.SetFuzzyMatching(3, 0.5);
+    assert(false);
+  } catch (const invalid_argument&) {
+  }
+  // Skipping a prefix that is too far away reuses the cursor, so the
+  // memory of a lookup doesn't grow with the number of skipped prefixes.
+  const auto measure = [](int word_count) {
+    set<string> words;
+    for (int i = 0; i < word_count; ++i) {
+      // Up to 4096 two-character prefixes, too far from the query already.
+      const string prefix = {static_cast<char>('!' + i % 64),
+                             static_cast<char>('!' + i / 64 % 64)};
+      words.insert(prefix + to_string(100000 + i) + "longertail"s);
+    }
+    const TermDictionary dictionary(
+        vector<string_view>(words.begin(), words.end()));
+    CountingResource resource;
+    pmr::vector<TermDictionary::FuzzyMatch> matches(&resource);
+    dictionary.FindWithinDistance("qqqqqqqqqq"sv, 1, matches, &resource);
+    assert(matches.empty());
+    return resource.GetAllocatedBytes();
+  };
+  assert(measure(1000) == measure(20000));
+  cout << "OK!"s << endl;
+}
+
+void TestThreadPool() {
+  cout << "TestThreadPool: \t\t"s;
+  {
+    atomic<int> sum = 0;
+    {
+      ThreadPool pool(4, 64);
+      vector<thread> submitters;
+      for (int t = 0; t < 4; ++t) {
+        submitters.emplace_back([&pool, &sum] {
+          for (int i = 1; i <= 1000; ++i) {
+            while (!pool.TrySubmit([&sum, i] { sum += i; })) {
+              this_thread::yield();
+            }
+          }
+        });
+      }
+      for (thread& submitter : submitters) {
+        submitter.join();
+      }
+    }
+    // The destructor runs the tasks that are still queued.
+    assert(sum == 4 * 500500);
+  }
+  {
+    ThreadPool pool(1, 1);
+    promise<void> started;
+    promise<void> release;
+    const shared_future<void> released = release.get_future().share();
+    assert(pool.TrySubmit([&started, released] {
+      started.set_value();
+      released.wait();
+    }));
+    started.get_future().wait();
+    assert(pool.TrySubmit([] {}));
+    assert(!pool.TrySubmit([] {}));
+    release.set_value();
+  }
+  cout << "OK!"s << endl;
+}
+
+// Counts its checks, and throws from the check after the first limit.
+class CountingInterrupt : public QueryInterrupt {
+ public:
+  explicit CountingInterrupt(int limit) : limit_(limit) {}
+
+  void Check() const override {
+    if (++check_count_ > limit_) {
+      throw QueryCancelled("Too many checks"s);
+    }
+  }
+
+  int GetCheckCount() const { return check_count_; }
+
+ private:
+  int limit_;
+  mutable int check_count_ = 0;
+};
+
+void TestAsyncSearchServer() {
+  cout << "TestAsyncSearchServer: \t\t"s;
+  SearchServer search_server("and"s);
+  search_server.AddDocument(1, "curly cat"s, DocumentStatus::ACTUAL, {1});
+  search_server.AddDocument(2, "curly dog and collar"s, DocumentStatus::ACTUAL,
+                            {2});
+  search_server.AddDocument(3, "big cat"s, DocumentStatus::BANNED, {3});
+  {
+    AsyncSearchServer async_server(search_server, 2, 16);
+    const vector<string> queries = {"curly"s, "cat"s, "dog -collar"s,
+                                    "big cat"s};
+    vector<future<vector<Document>>> results;
+    for (const string& query : queries) {
+      results.push_back(async_server.FindTopDocuments(query));
+    }
+    for (size_t i = 0; i < queries.size(); ++i) {
+      const auto expected = search_server.FindTopDocuments(queries[i]);
+      const auto documents = results[i].get();
+      assert(GetIds(documents) == GetIds(expected));
+    }
+    assert((GetIds(async_server
+                       .FindTopDocuments("cat"s, DocumentStatus::BANNED)
+                       .get()) == vector<int>{3}));
+    assert(async_server.FindTopDocuments("curly -cat"s).get().size() == 1);
+    QueryOptions cancelled;
+    cancelled.cancellation.Cancel();
+    auto cancelled_result = async_server.FindTopDocuments("cat"s, cancelled);
+    try {
+      cancelled_result.get();
+      assert(false);
+    } catch (const QueryCancelled&) {
+    }
+    QueryOptions expired;
+    expired.deadline = chrono::steady_clock::now() - chrono::seconds(1);
+    auto expired_result = async_server.FindTopDocuments("cat"s, expired);
+    try {
+      expired_result.get();
+      assert(false);
+    } catch (const QueryCancelled&) {
+    }
+    auto invalid_result = async_server.FindTopDocuments("cat --dog"s);
+    try {
+      invalid_result.get();
+      assert(false);
+    } catch (const invalid_argument&) {
+    }
+  }
+  {
+    // The first query holds the only worker, the second one fills the
+    // queue, and the third one is rejected.
+    AsyncSearchServer async_server(search_server, 1, 1);
+    promise<void> started;
+    promise<void> release;
+    const shared_future<void> released = release.get_future().share();
+    atomic<bool> is_started = false;
+    auto blocked = async_server.FindTopDocuments(
+        "cat"s, [&started, &is_started, released](int, DocumentStatus, int) {
+          if (!is_started.exchange(true)) {
+            started.set_value();
+          }
+          released.wait();
+          return true;
+        });
+    started.get_future().wait();
+    auto queued = async_server.FindTopDocuments("dog"s);
+    auto rejected = async_server.FindTopDocuments("curly"s);
+    try {
+      rejected.get();
+      assert(false);
+    } catch (const overflow_error&) {
+    }
+    release.set_value();
+    assert(blocked.get().size() == 2);
+    assert((GetIds(queued.get()) == vector<int>{2}));
+  }
+  {
+    // A running query is checked while it scores postings, even those its
+    // predicate never sees, and before it expands a word.
+    SearchServer large_server(""s);
+    for (int id = 0; id < 2000; ++id) {
+      large_server.AddDocument(id, "curly cat"s, DocumentStatus::ACTUAL, {1});
+    }
+    large_server.SetFuzzyMatching(1, 0.5);
+    const auto reject_all = [](int, DocumentStatus, int) { return false; };
+    const CountingInterrupt counting(INT_MAX);
+    assert(large_server
+               .FindTopDocuments("cat"s, {}, reject_all, TfIdfScorer{},
+                                 &counting)
+               .empty());
+    assert(counting.GetCheckCount() >= 2000 / 256);
+    large_server.SetQueryMemoryLimit(1);
+    const CountingInterrupt streaming(INT_MAX);
+    large_server.FindTopDocuments("cat"s, {}, reject_all, TfIdfScorer{},
+                                  &streaming);
+    assert(streaming.GetCheckCount() >= 2000 / 256);
+    for (const string& query : {"dog*"s, "doggy"s}) {
+      const CountingInterrupt stopping(0);
+      try {
+        large_server.FindTopDocuments(query, {}, reject_all, TfIdfScorer{},
+                                      &stopping);
+        assert(false);
+      } catch (const QueryCancelled&) {
+      }
+    }
+  }
+  cout << "OK!"s << endl;
+}
+
+void TestSegmentedSearchServer() {
+  cout << "TestSegmentedSearchServer: \t"s;
+  {
+    SegmentedSearchServer search_server("and"s, 2, 2);
+    search_server.AddDocument(1, "curly cat"s, DocumentStatus::ACTUAL, {1});
+    // Buffered documents aren't searchable yet.
+    assert(search_server.GetDocumentCount() == 0);
+    assert(search_server.FindTopDocuments("cat"s).empty());
+    search_server.AddDocument(2, "big dog"s, DocumentStatus::ACTUAL, {2});
+    assert(search_server.GetDocumentCount() == 2);
+    assert(search_server.GetSegmentCount() == 1);
+    search_server.AddDocument(3, "big cat"s, DocumentStatus::BANNED, {3});
+    search_server.Flush();
+    assert((GetIds(search_server.FindTopDocuments(
+                "cat"s, DocumentStatus::BANNED)) == vector<int>{3}));
+    // Removal hides a document at once, also one still in the buffer.
+    search_server.RemoveDocument(1);
+    assert(search_server.FindTopDocuments("curly"s).empty());
+    search_server.AddDocument(4, "curly cat"s, DocumentStatus::ACTUAL, {4});
+    search_server.RemoveDocument(4);
+    assert(search_server.GetDocumentCount() == 2);
+    assert(search_server.FindTopDocuments("curly"s).empty());
+    try {
+      search_server.AddDocument(2, "dog"s, DocumentStatus::ACTUAL, {});
+      assert(false);
+    } catch (const invalid_argument&) {
+    }
+    try {
+      search_server.RemoveDocument(1);
+      assert(false);
+    } catch (const invalid_argument&) {
+    }
+    for (const string& query : {"cat*"s, "\"big cat\""s}) {
+      try {
+        search_server.FindTopDocuments(query);
+        assert(false);
+      } catch (const invalid_argument&) {
+      }
+    }
+  }
+  {
+    // Documents, queries and stop words go through the tokenizer.
+    SegmentedSearchServer search_server("The"s, 1, 2, Tokenizer::Unicode());
+    search_server.AddDocument(1, "The Curly, CAT."s, DocumentStatus::ACTUAL,
+                              {1});
+    search_server.AddDocument(2, "the dog"s, DocumentStatus::ACTUAL, {2});
+    assert((GetIds(search_server.FindTopDocuments("cat!"s)) ==
+            vector<int>{1}));
+    assert(search_server.FindTopDocuments("THE"s).empty());
+    assert(search_server.FindTopDocuments("Curly -Cat"s).empty());
+  }
+  {
+    // Merged segments rank documents like a single index.
+    SegmentedSearchServer segmented("and"s, 3, 2);
+    SearchServer search_server("and"s);
+    const vector<string> words = {"cat"s, "dog"s, "and"s, "bird"s,
+                                  "fish"s, "curly"s};
+    for (int id = 0; id < 100; ++id) {
+      string text;
+      for (int i = 0; i <= id % 5; ++i) {
+        text += words[(id * 7 + i * 3) % words.size()] + " "s;
+      }
+      segmented.AddDocument(id, text, DocumentStatus::ACTUAL, {id % 7});
+      if (id % 10 != 3) {
+        search_server.AddDocument(id, text, DocumentStatus::ACTUAL,
+                                  {id % 7});
+      }
+    }
+    for (int id = 3; id < 100; id += 10) {
+      segmented.RemoveDocument(id);
+    }
+    segmented.Flush();
+    segmented.WaitForMerges();
+    assert(segmented.GetSegmentCount() <= 2);
+    assert(segmented.GetDocumentCount() == search_server.GetDocumentCount());
+    for (const string& query : {"cat"s, "dog -bird"s, "curly fish"s}) {
+      const auto expected = search_server.FindTopDocuments(query);
+      const auto documents = segmented.FindTopDocuments(query);
+      assert(documents.size() == expected.size());
+      for (size_t i = 0; i < documents.size(); ++i) {
+        assert(abs(documents[i].relevance - expected[i].relevance) < 1e-6);
+      }
+    }
+  }
+  {
+    // Queries run while another thread adds documents and see a growing
+    // count.
+    SegmentedSearchServer search_server(""s, 16, 3);
+    thread writer([&search_server] {
+      for (int id = 0; id < 2000; ++id) {
+        search_server.AddDocument(id, "word"s + to_string(id % 10),
+                                  DocumentStatus::ACTUAL, {});
+      }
+      search_server.Flush();
+    });
+    int document_count = 0;
+    while (document_count < 2000) {
+      const int current = search_server.GetDocumentCount();
+      assert(current >= document_count);
+      document_count = current;
+      search_server.FindTopDocuments("word3"s);
+    }
+    writer.join();
+  }
+  cout << "OK!"s << endl;
+}
+
+void TestStreamingQueries() {
+  cout << "TestStreamingQueries: \t\t"s;
+  {
+    SearchServer search_server("a"s, IndexMode::POSITIONS);
+    const vector<string> words = {"curly"s, "cat"s, "dog"s, "big"s,
+                                  "fancy"s, "collar"s, "a"s, "tail"s};
+    unsigned random = 1;
+    for (int id = 0; id < 500; ++id) {
+      string text;
+      for (int i = 0; i < 3 + id % 6; ++i) {
+        random = random * 1103515245 + 12345;
+        text += words[(random >> 16) % words.size()] + " "s;
+      }
+      search_server.AddDocument(id, text, DocumentStatus::ACTUAL,
+                                {id});
+    }
+    search_server.SetProximityWeight(0.5);
+    SearchServer streaming(search_server);
+    streaming.SetQueryMemoryLimit(1);
+    const auto is_even = [](int document_id, DocumentStatus, int) {
+      return document_id % 2 == 0;
+    };
+    for (const string& query :
+         {"curly cat"s, "\"curly cat\""s, "big -dog"s, "\"a tail\" collar"s,
+          "fancy collar tail"s, "c*"s, "-cat dog"s}) {
+      for (int with_predicate = 0; with_predicate < 2; ++with_predicate) {
+        const auto expected =
+            with_predicate ? search_server.FindTopDocuments(query, is_even)
+                           : search_server.FindTopDocuments(query);
+        const auto documents =
+            with_predicate ? streaming.FindTopDocuments(query, is_even)
+                           : streaming.FindTopDocuments(query);
+        assert(GetIds(documents) == GetIds(expected));
+        for (size_t i = 0; i < documents.size(); ++i) {
+          assert(abs(documents[i].relevance - expected[i].relevance) < 1e-9);
+        }
+      }
+    }
+  }
+  {
+    // Phrase and proximity checks reuse their buffers for each document.
+    SearchServer search_server(""s, IndexMode::POSITIONS);
+    search_server.SetQueryMemoryLimit(1);
+    search_server.SetProximityWeight(1.0);
+    const auto add_documents = [&search_server](int first, int last) {
+      for (int id = first; id < last; ++id) {
+        search_server.AddDocument(id, "curly cat with a curly tail"s,
+                                  DocumentStatus::ACTUAL, {id % 10});
+      }
+    };
+    const auto measure = [&search_server](const string& query) {
+      search_server.FindTopDocuments(query);
+      const size_t before = allocated_bytes;
+      assert(search_server.FindTopDocuments(query).size() == 5);
+      return allocated_bytes - before;
+    };
+    add_documents(0, 1000);
+    const size_t phrase_bytes = measure("\"curly cat\""s);
+    const size_t proximity_bytes = measure("curly tail"s);
+    add_documents(1000, 20000);
+    assert(measure("\"curly cat\""s) == phrase_bytes);
+    assert(measure("curly tail"s) == proximity_bytes);
+  }
+  cout << "OK!"s << endl;
+}
+
+void TestAttributeIndex() {
+  cout << "TestAttributeIndex: \t\t"s;
+  {
+    DocumentBitmap evens;
+    DocumentBitmap threes;
+    // Enough ids in the first container to turn it into a bitset, and
+    // some in a second container.
+    for (int id = 0; id < 20000; id += 2) {
+      evens.Add(id);
+    }
+    for (int id = 0; id < 70000; id += 3) {
+      threes.Add(id);
+    }
+    assert(evens.GetCount() == 10000 && threes.GetCount() == 23334);
+    const DocumentBitmap sixes = evens & threes;
+    assert(sixes.GetCount() == 3334);
+    assert(sixes.Contains(19998) && !sixes.Contains(20004));
+    assert(!sixes.Contains(3) && !sixes.Contains(4));
+    const DocumentBitmap any = evens | threes;
+    assert(any.GetCount() == 10000 + 23334 - 3334);
+    assert(any.Contains(69999) && any.Contains(4) && !any.Contains(5));
+    // A cursor walks bitset and array containers along a rising sequence.
+    for (const DocumentBitmap* bitmap : {&sixes, &any}) {
+      DocumentBitmap::Cursor cursor(*bitmap);
+      for (int id = 0; id < 75000; id += 1 + id % 7) {
+        assert(cursor.Contains(id) == bitmap->Contains(id));
+      }
+    }
+    vector<int> ids;
+    threes.ForEach([&ids](int id) { ids.push_back(id); });
+    assert(ids.size() == 23334 && ids[1] == 3 && ids.back() == 69999);
+    assert(is_sorted(ids.begin(), ids.end()));
+  }
+  {
+    // Documents added out of id order, with ratings spread over many
+    // rating buckets, select like a scan of their attributes.
+    SearchServer search_server(""s);
+    search_server.EnableAttributeIndex();
+    const vector<int> ratings = {INT_MIN, -1000, -9, -8, -7, -1, 0,
+                                 1,       2,     3,  7,  8,  1000, INT_MAX};
+    const auto make_text = [](int id) {
+      return "cat"s + string(id % 4, 's') + (id % 3 ? " dog bird"s : ""s);
+    };
+    for (int i = 0; i < 500; ++i) {
+      const int id = (i * 337) % 500;
+      search_server.AddDocument(id, make_text(id), DocumentStatus::ACTUAL,
+                                {ratings[id % ratings.size()]});
+    }
+    for (const auto& [min_rating, max_rating] :
+         vector<pair<int, int>>{{INT_MIN, INT_MAX}, {-8, 7}, {-7, -7},
+                                {2, 3}, {3, 2}, {-1000, 0}, {9, INT_MAX}}) {
+      const DocumentBitmap selected =
+          search_server.SelectByRating(min_rating, max_rating);
+      const DocumentBitmap expected = search_server.SelectDocuments(
+          [min_rating = min_rating, max_rating = max_rating](
+              int, DocumentStatus, int rating) {
+            return rating >= min_rating && rating <= max_rating;
+          });
+      assert(selected.GetCount() == expected.GetCount());
+      assert((selected & expected).GetCount() == expected.GetCount());
+    }
+    // Queries read the attributes from the index.
+    SearchServer plain(""s);
+    for (int id = 0; id < 500; ++id) {
+      plain.AddDocument(id, make_text(id), DocumentStatus::ACTUAL,
+                        {ratings[id % ratings.size()]});
+    }
+    const auto positive = [](int, DocumentStatus, int rating) {
+      return rating > 0;
+    };
+    assert(GetIds(search_server.FindTopDocuments("cat cats"s, positive,
+                                                 Bm25Scorer{})) ==
+           GetIds(plain.FindTopDocuments("cat cats"s, positive,
+                                         Bm25Scorer{})));
+    assert(GetIds(search_server.FindTopDocuments(
+               "cat cats"s, search_server.SelectByRating(1, INT_MAX),
+               Bm25Scorer{})) ==
+           GetIds(plain.FindTopDocuments("cat cats"s, positive,
+                                         Bm25Scorer{})));
+  }
+  {
+    SearchServer search_server(""s);
+    try {
+      search_server.SelectByStatus(DocumentStatus::ACTUAL);
+      assert(false);
+    } catch (const logic_error&) {
+    }
+    search_server.AddDocument(1, "cat dog"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(2, "cat"s, DocumentStatus::BANNED, {5});
+    // Documents added before the index is enabled are indexed too.
+    search_server.EnableAttributeIndex();
+    search_server.AddDocument(3, "cat bird"s, DocumentStatus::ACTUAL, {3});
+    search_server.AddDocument(4, "cat fish"s, DocumentStatus::ACTUAL, {7});
+    const DocumentBitmap actual =
+        search_server.SelectByStatus(DocumentStatus::ACTUAL);
+    assert(actual.GetCount() == 3 && !actual.Contains(2));
+    const DocumentBitmap rated = search_server.SelectByRating(3, 6);
+    assert(rated.GetCount() == 2 && rated.Contains(2) && rated.Contains(3));
+    const DocumentBitmap selected = search_server.SelectDocuments(
+        [](int document_id, DocumentStatus status, int rating) {
+          return document_id != 4 && status == DocumentStatus::ACTUAL &&
+                 rating > 0;
+        });
+    assert(selected.GetCount() == 2 && selected.Contains(1) &&
+           selected.Contains(3));
+    const auto filter = [](int document_id, DocumentStatus status, int) {
+      return status == DocumentStatus::ACTUAL && document_id != 3;
+    };
+    const DocumentBitmap bitmap =
+        search_server.SelectDocuments(filter) | rated;
+    const auto expected = search_server.FindTopDocuments(
+        "cat"s, [&](int document_id, DocumentStatus status, int rating) {
+          return filter(document_id, status, rating) ||
+                 (rating >= 3 && rating <= 6);
+        });
+    assert((GetIds(expected) == vector<int>{4, 2, 3, 1}));
+    assert(GetIds(search_server.FindTopDocuments("cat"s, bitmap)) ==
+           GetIds(expected));
+    assert((GetIds(search_server.FindTopDocuments("cat"s, actual & rated)) ==
+            vector<int>{3}));
+    search_server.SetQueryMemoryLimit(1);
+    assert(GetIds(search_server.FindTopDocuments("cat"s, bitmap)) ==
+           GetIds(expected));
+  }
+  cout << "OK!"s << endl;
+}
+
+void TestDocumentStore() {
+  cout << "TestDocumentStore: \t\t"s;
+  {
+    // Repetitive and random texts over several compressed blocks.
+    SearchServer search_server(""s);
+    search_server.EnableDocumentStore();
+    vector<string> texts;
+    unsigned random = 1;
+    for (int id = 0; id < 3000; ++id) {
+      string text;
+      for (int i = 0; i < 5 + id % 40; ++i) {
+        random = random * 1103515245 + 12345;
+        text += id % 2 ? "curly cat "s : to_string(random >> 8) + " "s;
+      }
+      text += to_string(id);
+      search_server.AddDocument(id, text, DocumentStatus::ACTUAL, {1});
+      texts.push_back(text);
+    }
+    for (int id = 0; id < 3000; ++id) {
+      assert(search_server.GetDocumentText(id) == texts[id]);
+    }
+    const auto documents = search_server.FindTopDocuments("cat 7 2999"s);
+    const auto found_texts = search_server.GetDocumentTexts(documents);
+    assert(found_texts.size() == documents.size());
+    for (size_t i = 0; i < documents.size(); ++i) {
+      assert(found_texts[i] == texts[documents[i].id]);
+    }
+    const SearchServer copy(search_server);
+    assert(copy.GetDocumentText(2999) == texts[2999]);
+    ostringstream output;
+    DocumentStore store;
+    store.Add(1, texts[1]);
+    store.Add(2, texts[2]);
+    store.Save(output);
+    const string image = output.str();
+    const DocumentStore opened = DocumentStore::Open(image);
+    assert(opened.Contains(2) && !opened.Contains(3));
+    assert((opened.Get(vector<int>{2, 1}) == vector{texts[2], texts[1]}));
+    // Counts, offsets and sizes that don't fit the image are rejected.
+    // The block count is at byte 4, the document count at byte 8 and the
+    // block offsets from byte 12.
+    const auto expect_invalid = [&image](size_t position, auto value) {
+      string corrupted = image;
+      memcpy(corrupted.data() + position, &value, sizeof(value));
+      try {
+        DocumentStore::Open(corrupted);
+        assert(false);
+      } catch (const invalid_argument&) {
+      }
+    };
+    expect_invalid(4, UINT32_MAX);
+    expect_invalid(8, UINT32_MAX);
+    expect_invalid(12, uint64_t{1});
+    expect_invalid(20, uint64_t{0});
+    expect_invalid(20, uint64_t{image.size()});
+    try {
+      DocumentStore::Open(image + "x"s);
+      assert(false);
+    } catch (const invalid_argument&) {
+    }
+  }
+  {
+    string text;
+    for (int i = 0; i < 40; ++i) {
+      text += (i == 20 ? "cat"s : "w"s + to_string(i)) + " "s;
+    }
+    for (const IndexMode mode :
+         {IndexMode::FREQUENCIES, IndexMode::POSITIONS}) {
+      SearchServer search_server(""s, mode);
+      search_server.EnableDocumentStore();
+      search_server.AddDocument(1, text, DocumentStatus::ACTUAL, {1});
+      search_server.AddDocument(2, "curly cat with a fluffy tail"s,
+                                DocumentStatus::ACTUAL, {1});
+      assert(search_server.GetSnippet(1, "cat"s) ==
+             "... [cat] w21 w22 w23 w24 w25 w26 w27 w28 w29 w30 w31 ..."s);
+      assert(search_server.GetSnippet(2, "tail -dog curly"s) ==
+             "[curly] cat with a fluffy [tail]"s);
+      assert(search_server.GetSnippet(2, "bird"s) ==
+             "curly cat with a fluffy tail"s);
+    }
+  }
+  {
+    SearchServer search_server(""s);
+    search_server.AddDocument(1, "cat"s, DocumentStatus::ACTUAL, {1});
+    try {
+      search_server.GetDocumentText(1);
+      assert(false);
+    } catch (const logic_error&) {
+    }
+    try {
+      search_server.EnableDocumentStore();
+      assert(false);
+    } catch (const logic_error&) {
+    }
+  }
+  cout << "OK!"s << endl;
+}
+
+void AddFieldDocuments(SearchServerBase& search_server) {
+  search_server.AddDocument(1, {{"title"sv, "cat"sv}, {"body"sv, "dog bird"sv}},
+                            DocumentStatus::ACTUAL, {1});
+  search_server.AddDocument(2, {{"title"sv, "dog"sv}, {"body"sv, "cat bird"sv}},
+                            DocumentStatus::ACTUAL, {2});
+  search_server.AddDocument(3, "fish"s, DocumentStatus::ACTUAL, {3});
+}
+
+void TestFieldWeights() {
+  cout << "TestFieldWeights: \t\t"s;
+  {
+    SearchServer search_server(""s);
+    AddFieldDocuments(search_server);
+    // Without weights the fields are one text, and 1 and 2 tie.
+    const auto documents = search_server.FindTopDocuments("cat"s);
+    assert((GetIds(documents) == vector<int>{2, 1}));
+    assert(documents[0].relevance == documents[1].relevance);
+    assert(GetIds(search_server.FindTopDocuments(
+               "cat"s, FieldWeights{{"title"s, 5.0}})) == vector({1, 2}));
+    assert(GetIds(search_server.FindTopDocuments(
+               "cat"s, FieldWeights{{"body"s, 5.0}})) == vector({2, 1}));
+    // A weight of 0 drops a field's matches, unknown fields are ignored.
+    const auto no_title = search_server.FindTopDocuments(
+        "cat"s, FieldWeights{{"title"s, 0.0}, {"year"s, 3.0}});
+    assert((GetIds(no_title) == vector<int>{2, 1}));
+    assert(no_title[0].relevance == documents[0].relevance);
+    assert(abs(no_title[1].relevance) < 1e-9);
+    try {
+      search_server.FindTopDocuments("cat"s, FieldWeights{{"title"s, -1.0}});
+      assert(false);
+    } catch (const invalid_argument&) {
+    }
+    try {
+      search_server.AddDocument(4, {{""sv, "cat"sv}}, DocumentStatus::ACTUAL,
+                                {1});
+      assert(false);
+    } catch (const invalid_argument&) {
+    }
+  }
+  {
+    optional<SearchServer> source(in_place, ""s);
+    AddFieldDocuments(*source);
+    SearchServer copy(*source);
+    SearchServer assigned(""s);
+    assigned = *source;
+    source.reset();
+    for (const SearchServer* search_server : {&copy, &assigned}) {
+      assert(GetIds(search_server->FindTopDocuments(
+                 "cat"s, FieldWeights{{"title"s, 5.0}})) == vector({1, 2}));
+    }
+  }
+  {
+    // The weight scales the term frequency, so BM25 still saturates it.
+    const auto any = [](int, DocumentStatus, int) { return true; };
+    const Bm25Scorer scorer;
+    const auto term = scorer.PrepareTerm({3.0, 7.0 / 3.0}, 2);
+    const double plain = scorer.Score(term, 1.0 / 3.0, 3);
+    const double weighted = scorer.Score(term, 5.0 / 3.0, 3);
+    assert(weighted < 5.0 * plain);
+    for (const size_t memory_limit : {0, 1}) {
+      SearchServer search_server(""s);
+      search_server.SetQueryMemoryLimit(memory_limit);
+      AddFieldDocuments(search_server);
+      const auto documents = search_server.FindTopDocuments(
+          "cat"s, FieldWeights{{"title"s, 5.0}}, any, scorer);
+      assert((GetIds(documents) == vector<int>{1, 2}));
+      assert(abs(documents[0].relevance - weighted) < 1e-9);
+      assert(abs(documents[1].relevance - plain) < 1e-9);
+    }
+  }
+  {
+    // Phrases don't span two fields, and snippets skip the gap between them.
+    SearchServer search_server(""s, IndexMode::POSITIONS);
+    search_server.EnableDocumentStore();
+    AddFieldDocuments(search_server);
+    assert(search_server.FindTopDocuments("\"cat dog\""s).empty());
+    assert(GetIds(search_server.FindTopDocuments("\"cat bird\""s)) ==
+           vector({2}));
+    assert(search_server.GetSnippet(1, "bird"s) == "... [bird]"s);
+    assert(search_server.GetSnippet(2, "dog cat"s) == "[dog] [cat] bird"s);
+  }
+  cout << "OK!"s << endl;
+}
+
+void TestTokenizer() {
+  cout << "TestTokenizer: \t\t\t"s;
+  {
+    const Tokenizer tokenizer = Tokenizer::Unicode();
+    assert(Tokenizer().IsIdentity() && !tokenizer.IsIdentity());
+    assert(Tokenizer().Normalize("Cat, DOG"s) == "Cat, DOG"s);
+    // Long ASCII runs go eight bytes at a time.
+    assert(tokenizer.Normalize("ABCDEFGHIJ-klmnop.QRS_t"s) ==
+           "abcdefghij klmnop qrs t"s);
+    assert(tokenizer.Normalize("Ёжик КОТ ΑΘΗΝΑ ÉCOLE"s) ==
+           "ёжик кот αθηνα école"s);
+    assert(tokenizer.Normalize("«кот»—пёс…"s) == "  кот     пёс   "s);
+    assert(Tokenizer(false, true).Normalize("«Кот»"s) == "«кот»"s);
+    assert(Tokenizer(true, false).Normalize("«Кот»"s) == "  Кот  "s);
+    string query = "-Кот \"Big Dog\" cat* e-mail x*y -"s;
+    tokenizer.NormalizeQuery(query, query.data());
+    assert(query == "-кот \"big dog\" cat* e mail x y  "s);
+  }
+  {
+    SearchServer search_server("И the"s, IndexMode::POSITIONS,
+                               Tokenizer::Unicode());
+    search_server.EnableDocumentStore();
+    search_server.AddDocument(1, "Пушистый КОТ, и хвост!"s,
+                              DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(2, "Ёжик в тумане"s, DocumentStatus::ACTUAL,
+                              {2});
+    search_server.AddDocument(3, "THE ΑΘΗΝΑ Café"s, DocumentStatus::ACTUAL,
+                              {3});
+    assert((GetIds(search_server.FindTopDocuments("кот"s)) == vector{1}));
+    assert((GetIds(search_server.FindTopDocuments("КОТ ЁЖИК"s)) ==
+            vector{2, 1}));
+    assert(search_server.FindTopDocuments("кот -ХВОСТ!"s).empty());
+    assert(search_server.FindTopDocuments("и the"s).empty());
+    assert(
+        (GetIds(search_server.FindTopDocuments("\"пушистый, кот\""s)) ==
+         vector{1}));
+    assert((GetIds(search_server.FindTopDocuments("αθηνα CAFÉ"s)) ==
+            vector{3}));
+    const auto [words, status] = search_server.MatchDocument("ХВОСТ Кот"s, 1);
+    assert((words == vector{"кот"s, "хвост"s}));
+    // Snippets show the words as written, without the separators.
+    assert(search_server.GetSnippet(1, "кот"s) == "... [КОТ] и хвост"s);
+    assert(search_server.GetSnippet(1, "хвост пушистый"s) ==
+           "[Пушистый] КОТ и [хвост]"s);
+    assert(search_server.GetSnippet(3, "cafÉ"s) == "... [Café]"s);
+  }
+  cout << "OK!"s << endl;
+}
+
+struct TopTwoConfig {
+  static constexpr int MAX_RESULT_DOCUMENT_COUNT = 2;
+  static constexpr double EPSILON = 0.1;
+  using Score = float;
+  using Accumulator = pmr::unordered_map<int, Score>;
+};
+
+void TestConfig() {
+  cout << "TestConfig: \t\t\t"s;
+  BasicSearchServer<TopTwoConfig> search_server("and"s);
+  search_server.AddDocument(1, "cat and dog"s, DocumentStatus::ACTUAL, {1});
+  search_server.AddDocument(2, "cat dog bird"s, DocumentStatus::ACTUAL, {2});
+  search_server.AddDocument(3, "cat"s, DocumentStatus::ACTUAL, {3});
+  search_server.AddDocument(4, "fish"s, DocumentStatus::ACTUAL, {4});
+  // The relevances of 1 and 2 differ by less than EPSILON, so 2 ranks
+  // above 1 by rating, and only two documents are returned.
+  const auto documents = search_server.FindTopDocuments("cat"s);
+  assert(documents.size() == 2);
+  assert(documents[0].id == 3 && documents[1].id == 2);
+  const auto many = search_server.FindTopDocuments("cat fish"s);
+  assert(many.size() == 2);
+  search_server.SetQueryMemoryLimit(1);
+  const auto streamed = search_server.FindTopDocuments("cat fish"s);
+  assert(streamed.size() == 2);
+  // Both ways accumulate in float.
+  for (size_t i = 0; i < streamed.size(); ++i) {
+    assert(streamed[i].id == many[i].id);
+    assert(streamed[i].relevance == many[i].relevance);
+  }
+  BasicSegmentedSearchServer<TopTwoConfig> segmented("and"s, 2, 2);
+  segmented.AddDocument(1, "cat and dog"s, DocumentStatus::ACTUAL, {1});
+  segmented.AddDocument(2, "cat dog bird"s, DocumentStatus::ACTUAL, {2});
+  segmented.AddDocument(3, "cat"s, DocumentStatus::ACTUAL, {3});
+  segmented.AddDocument(4, "fish"s, DocumentStatus::ACTUAL, {4});
+  assert(GetIds(segmented.FindTopDocuments("cat"s)) == GetIds(documents));
+  BasicAsyncSearchServer<TopTwoConfig> async_server(search_server, 1, 4);
+  assert(GetIds(async_server.FindTopDocuments("cat fish"s).get()) ==
+         GetIds(streamed));
+  cout << "OK!"s << endl;
+}
+
+void AllTests() {
+  TestQueryArena();
+  TestLoadDocuments();
+  TestPaginator();
+  TestScorers();
+  TestPhraseQueries();
+  TestPrefixQueries();
+  TestFuzzyQueries();
+  TestThreadPool();
+  TestAsyncSearchServer();
+  TestSegmentedSearchServer();
+  TestStreamingQueries();
+  TestAttributeIndex();
+  TestDocumentStore();
+  TestFieldWeights();
+  TestTokenizer();
+  TestConfig();
+}
+
 int main() {
+  AllTests();
+
   SearchServer search_server("and in at"s);
   RequestQueue request_queue(search_server);
 
@@ -2,7 +2,9 @@
 #include <algorithm>
 #include <cassert>
 #include <iostream>
-#include <vector>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
 
 #include "document.h"
 
@@ -11,16 +13,19 @@ using namespace std::string_literals;
 template <typename IteratorRanges>
 class IteratorRange {
  public:
+  IteratorRange() = default;
   explicit IteratorRange(IteratorRanges begin, IteratorRanges end)
       : begin_(begin), end_(end), size_(distance(begin, end)) {}
+  IteratorRange(IteratorRanges begin, IteratorRanges end, size_t size)
+      : begin_(begin), end_(end), size_(size) {}
   IteratorRanges begin() const { return begin_; }
   IteratorRanges end() const { return end_; }
   size_t size() const { return size_; }
 
  private:
-  IteratorRanges begin_;
-  IteratorRanges end_;
-  size_t size_;
+  IteratorRanges begin_{};
+  IteratorRanges end_{};
+  size_t size_ = 0;
 };
 
 template <typename To_Out>
@@ -34,32 +39,113 @@ std::ostream& operator<<(std::ostream& out,
   return out;
 }
 
+// A view that cuts [begin, end) into pages of size_of_sheet elements.
+// Pages are computed while iterating, so nothing is allocated; with
+// random-access iterators size() and operator[] are O(1).
 template <typename Paginatorr>
 class Paginator {
+  static constexpr bool IS_RANDOM_ACCESS = std::is_base_of_v<
+      std::random_access_iterator_tag,
+      typename std::iterator_traits<Paginatorr>::iterator_category>;
+
  public:
-  Paginator(const Paginatorr& result_begin, const Paginatorr& result_end,
-            size_t size_of_sheet) {
-    auto full_size = distance(result_begin, result_end);
-    Paginatorr helper = result_begin;
-    for (auto i = 0; i < full_size / size_of_sheet; ++i) {
-      sheets.push_back(
-          IteratorRange<Paginatorr>(helper, helper + size_of_sheet));
-      helper = helper + size_of_sheet;
+  using Page = IteratorRange<Paginatorr>;
+
+  class PageIterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = Page;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const Page*;
+    using reference = const Page&;
+
+    PageIterator() = default;
+
+    PageIterator(Paginatorr sheet_begin, Paginatorr result_end,
+                 size_t size_of_sheet)
+        : sheet_(MakeSheet(sheet_begin, result_end, size_of_sheet)),
+          result_end_(result_end),
+          size_of_sheet_(size_of_sheet) {}
+
+    const Page& operator*() const { return sheet_; }
+    const Page* operator->() const { return &sheet_; }
+
+    PageIterator& operator++() {
+      sheet_ = MakeSheet(sheet_.end(), result_end_, size_of_sheet_);
+      return *this;
+    }
+
+    PageIterator operator++(int) {
+      auto old = *this;
+      ++*this;
+      return old;
     }
-    if (helper != result_end) {
-      sheets.push_back(IteratorRange<Paginatorr>(helper, result_end));
+
+    bool operator==(const PageIterator& rhs) const {
+      return sheet_.begin() == rhs.sheet_.begin();
+    }
+    bool operator!=(const PageIterator& rhs) const { return !(*this == rhs); }
+
+   private:
+    Page sheet_;
+    Paginatorr result_end_{};
+    size_t size_of_sheet_ = 0;
+  };
+
+  Paginator(const Paginatorr& result_begin, const Paginatorr& result_end,
+            size_t size_of_sheet)
+      : result_begin_(result_begin),
+        result_end_(result_end),
+        size_of_sheet_(size_of_sheet) {
+    if (size_of_sheet == 0) {
+      throw std::invalid_argument("Page size must be positive"s);
     }
   }
 
-  auto begin() const { return sheets.begin(); }
-  auto end() const { return sheets.end(); }
-  size_t size() { return sheets.size(); }
+  PageIterator begin() const {
+    return PageIterator(result_begin_, result_end_, size_of_sheet_);
+  }
+  PageIterator end() const {
+    return PageIterator(result_end_, result_end_, size_of_sheet_);
+  }
+
+  size_t size() const {
+    const size_t full_size = distance(result_begin_, result_end_);
+    return (full_size + size_of_sheet_ - 1) / size_of_sheet_;
+  }
+
+  Page operator[](size_t index) const {
+    static_assert(IS_RANDOM_ACCESS,
+                  "Page access by index requires random-access iterators");
+    assert(index < size());
+    return MakeSheet(result_begin_ + index * size_of_sheet_, result_end_,
+                     size_of_sheet_);
+  }
 
  private:
-  std::vector<IteratorRange<Paginatorr>> sheets;
+  Paginatorr result_begin_;
+  Paginatorr result_end_;
+  size_t size_of_sheet_;
+
+  static Page MakeSheet(Paginatorr sheet_begin, Paginatorr result_end,
+                        size_t size_of_sheet) {
+    if constexpr (IS_RANDOM_ACCESS) {
+      const size_t sheet_size = std::min<size_t>(
+          size_of_sheet, std::distance(sheet_begin, result_end));
+      return Page(sheet_begin, sheet_begin + sheet_size, sheet_size);
+    } else {
+      Paginatorr sheet_end = sheet_begin;
+      size_t sheet_size = 0;
+      while (sheet_size < size_of_sheet && sheet_end != result_end) {
+        ++sheet_end;
+        ++sheet_size;
+      }
+      return Page(sheet_begin, sheet_end, sheet_size);
+    }
+  }
 };
 
 template <typename Container>
 auto Paginate(const Container& c, size_t page_size) {
   return Paginator(begin(c), end(c), page_size);
-}
\ No newline at end of file
+}
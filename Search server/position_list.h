@@ -0,0 +1,67 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// Ascending token positions of a word in one document, stored as varint
+// encoded gaps.
+using PositionList = std::vector<uint8_t>;
+
+inline void AppendPosition(PositionList& list, uint32_t gap) {
+  while (gap >= 0x80) {
+    list.push_back(static_cast<uint8_t>(gap | 0x80));
+    gap >>= 7;
+  }
+  list.push_back(static_cast<uint8_t>(gap));
+}
+
+template <typename Positions>
+PositionList EncodePositions(const Positions& positions) {
+  PositionList list;
+  uint32_t previous = 0;
+  for (const uint32_t position : positions) {
+    AppendPosition(list, position - previous);
+    previous = position;
+  }
+  list.shrink_to_fit();
+  return list;
+}
+
+class PositionReader {
+ public:
+  PositionReader() = default;
+
+  explicit PositionReader(const PositionList& list)
+      : current_(list.data()), end_(list.data() + list.size()) {}
+
+  bool Next(uint32_t& position) {
+    if (current_ == end_) {
+      return false;
+    }
+    uint32_t gap = 0;
+    for (int shift = 0;; shift += 7) {
+      const uint8_t byte = *current_++;
+      gap |= static_cast<uint32_t>(byte & 0x7F) << shift;
+      if (!(byte & 0x80)) {
+        break;
+      }
+    }
+    position_ += gap;
+    position = position_;
+    return true;
+  }
+
+  // Skips to the first position not less than target.
+  bool SeekTo(uint32_t target, uint32_t& position) {
+    while (Next(position)) {
+      if (position >= target) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+ private:
+  const uint8_t* current_ = nullptr;
+  const uint8_t* end_ = nullptr;
+  uint32_t position_ = 0;
+};
@@ -0,0 +1,48 @@
+#include "query_arena.h"
+
+#include <array>
+#include <cstddef>
+
+namespace {
+
+constexpr size_t INITIAL_BUFFER_SIZE = 64 * 1024;
+constexpr size_t LARGEST_POOLED_BLOCK = 4 * 1024 * 1024;
+
+struct ThreadScratch {
+  std::array<std::byte, INITIAL_BUFFER_SIZE> buffer;
+  std::pmr::unsynchronized_pool_resource spill{
+      std::pmr::pool_options{0, LARGEST_POOLED_BLOCK},
+      std::pmr::new_delete_resource()};
+  std::pmr::monotonic_buffer_resource arena{buffer.data(), buffer.size(),
+                                            &spill};
+  bool in_use = false;
+};
+
+ThreadScratch& GetThreadScratch() {
+  thread_local ThreadScratch scratch;
+  return scratch;
+}
+
+}  // namespace
+
+QueryArena::QueryArena() {
+  auto& scratch = GetThreadScratch();
+  if (scratch.in_use) {
+    // A predicate started another query on this thread: give it its own
+    // arena so the outer query's memory stays valid.
+    nested_.emplace(&scratch.spill);
+    resource_ = &*nested_;
+  } else {
+    scratch.in_use = true;
+    resource_ = &scratch.arena;
+  }
+}
+
+QueryArena::~QueryArena() {
+  if (nested_) {
+    return;
+  }
+  auto& scratch = GetThreadScratch();
+  scratch.arena.release();
+  scratch.in_use = false;
+}
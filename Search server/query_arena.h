@@ -0,0 +1,22 @@
+#pragma once
+#include <memory_resource>
+#include <optional>
+
+// Per-thread scratch memory for one query. Everything allocated through
+// Resource() is dropped at once when the arena goes out of scope, and the
+// thread's buffer is reused by the next query.
+class QueryArena {
+ public:
+  QueryArena();
+
+  QueryArena(const QueryArena&) = delete;
+  QueryArena& operator=(const QueryArena&) = delete;
+
+  ~QueryArena();
+
+  std::pmr::memory_resource* Resource() noexcept { return resource_; }
+
+ private:
+  std::pmr::memory_resource* resource_ = nullptr;
+  std::optional<std::pmr::monotonic_buffer_resource> nested_;
+};
@@ -0,0 +1,36 @@
+#pragma once
+
+// Lets the caller of a query stop it while it runs: Check is called as the
+// query expands its words and scores postings, and throws to abort it.
+class QueryInterrupt {
+ public:
+  virtual void Check() const = 0;
+
+ protected:
+  ~QueryInterrupt() = default;
+};
+
+// Calls Check of an optional QueryInterrupt on every CHECK_PERIOD-th call
+// to Poll, so a check may cost as much as reading the clock.
+class QueryPoller {
+ public:
+  explicit QueryPoller(const QueryInterrupt* interrupt)
+      : interrupt_(interrupt) {}
+
+  void Check() const {
+    if (interrupt_ != nullptr) {
+      interrupt_->Check();
+    }
+  }
+
+  void Poll() {
+    if (interrupt_ != nullptr && ++poll_count_ % CHECK_PERIOD == 0) {
+      interrupt_->Check();
+    }
+  }
+
+ private:
+  static constexpr unsigned CHECK_PERIOD = 256;
+  const QueryInterrupt* interrupt_;
+  unsigned poll_count_ = 0;
+};
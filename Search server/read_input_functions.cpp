@@ -1,6 +1,18 @@
 #include "read_input_functions.h"
 
+#include <algorithm>
+#include <charconv>
+#include <condition_variable>
+#include <deque>
+#include <exception>
 #include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "search_server.h"
 
 using namespace std::string_literals;
 
@@ -15,4 +27,250 @@ int ReadLineWithNumber() {
   std::cin >> result;
   ReadLine();
   return result;
-}
\ No newline at end of file
+}
+
+namespace {
+
+constexpr size_t BLOCK_SIZE = 1 << 20;
+
+struct DocumentRecord {
+  int id;
+  DocumentStatus status;
+  size_t ratings_begin;
+  size_t ratings_end;
+  std::string_view text;
+};
+
+struct RecordBlock {
+  std::vector<char> data;
+  std::vector<DocumentRecord> records;
+  std::vector<int> ratings;
+};
+
+class BlockPipeline {
+ public:
+  explicit BlockPipeline(size_t block_count) : blocks_(block_count) {
+    for (auto& block : blocks_) {
+      free_.push_back(&block);
+    }
+  }
+
+  RecordBlock* AcquireFree() {
+    std::unique_lock lock(mutex_);
+    changed_.wait(lock, [this] { return stopped_ || !free_.empty(); });
+    if (stopped_) {
+      return nullptr;
+    }
+    RecordBlock* block = free_.front();
+    free_.pop_front();
+    return block;
+  }
+
+  void PushFilled(RecordBlock* block) {
+    {
+      std::lock_guard lock(mutex_);
+      filled_.push_back(block);
+    }
+    changed_.notify_all();
+  }
+
+  void Finish(std::exception_ptr error) {
+    {
+      std::lock_guard lock(mutex_);
+      finished_ = true;
+      error_ = error;
+    }
+    changed_.notify_all();
+  }
+
+  RecordBlock* PopFilled() {
+    std::unique_lock lock(mutex_);
+    changed_.wait(lock, [this] { return finished_ || !filled_.empty(); });
+    if (filled_.empty()) {
+      if (error_) {
+        std::rethrow_exception(error_);
+      }
+      return nullptr;
+    }
+    RecordBlock* block = filled_.front();
+    filled_.pop_front();
+    return block;
+  }
+
+  void Release(RecordBlock* block) {
+    {
+      std::lock_guard lock(mutex_);
+      free_.push_back(block);
+    }
+    changed_.notify_all();
+  }
+
+  void Stop() {
+    {
+      std::lock_guard lock(mutex_);
+      stopped_ = true;
+    }
+    changed_.notify_all();
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable changed_;
+  std::vector<RecordBlock> blocks_;
+  std::deque<RecordBlock*> free_;
+  std::deque<RecordBlock*> filled_;
+  bool finished_ = false;
+  bool stopped_ = false;
+  std::exception_ptr error_;
+};
+
+std::string_view NextField(std::string_view& line) {
+  const auto field_begin = std::min(line.find_first_not_of(' '), line.size());
+  line.remove_prefix(field_begin);
+  const auto field_end = std::min(line.find(' '), line.size());
+  const auto field = line.substr(0, field_end);
+  line.remove_prefix(field_end);
+  return field;
+}
+
+bool ParseInt(std::string_view text, int& value) {
+  const auto [end, error] =
+      std::from_chars(text.data(), text.data() + text.size(), value);
+  return error == std::errc{} && end == text.data() + text.size();
+}
+
+bool ParseStatus(std::string_view text, DocumentStatus& status) {
+  static constexpr std::string_view STATUS_NAMES[] = {"ACTUAL", "IRRELEVANT",
+                                                      "BANNED", "REMOVED"};
+  for (size_t i = 0; i < std::size(STATUS_NAMES); ++i) {
+    if (text == STATUS_NAMES[i]) {
+      status = static_cast<DocumentStatus>(i);
+      return true;
+    }
+  }
+  int value = 0;
+  if (ParseInt(text, value) && value >= 0 &&
+      value < static_cast<int>(std::size(STATUS_NAMES))) {
+    status = static_cast<DocumentStatus>(value);
+    return true;
+  }
+  return false;
+}
+
+bool ParseRatings(std::string_view text, std::vector<int>& ratings) {
+  if (text == "-") {
+    return true;
+  }
+  while (true) {
+    const auto comma = std::min(text.find(','), text.size());
+    int rating = 0;
+    if (!ParseInt(text.substr(0, comma), rating)) {
+      return false;
+    }
+    ratings.push_back(rating);
+    if (comma == text.size()) {
+      return true;
+    }
+    text.remove_prefix(comma + 1);
+  }
+}
+
+void ParseRecords(std::string_view text, RecordBlock& block,
+                  size_t& line_number) {
+  while (!text.empty()) {
+    const auto line_end = std::min(text.find('\n'), text.size());
+    std::string_view line = text.substr(0, line_end);
+    text.remove_prefix(std::min(line_end + 1, text.size()));
+    ++line_number;
+    if (!line.empty() && line.back() == '\r') {
+      line.remove_suffix(1);
+    }
+    if (line.find_first_not_of(' ') == std::string_view::npos) {
+      continue;
+    }
+    DocumentRecord record{};
+    record.ratings_begin = block.ratings.size();
+    if (!ParseInt(NextField(line), record.id) ||
+        !ParseStatus(NextField(line), record.status) ||
+        !ParseRatings(NextField(line), block.ratings)) {
+      throw std::invalid_argument("Invalid document record at line "s +
+                                  std::to_string(line_number));
+    }
+    record.ratings_end = block.ratings.size();
+    record.text = line;
+    block.records.push_back(record);
+  }
+}
+
+void ReadBlocks(std::istream& input, BlockPipeline& pipeline) {
+  std::vector<char> carry;
+  size_t line_number = 0;
+  bool end_of_input = false;
+  while (!end_of_input) {
+    RecordBlock* block = pipeline.AcquireFree();
+    if (!block) {
+      return;
+    }
+    block->records.clear();
+    block->ratings.clear();
+    if (block->data.size() < std::max(BLOCK_SIZE, carry.size() * 2)) {
+      block->data.resize(std::max(BLOCK_SIZE, carry.size() * 2));
+    }
+    std::copy(carry.begin(), carry.end(), block->data.begin());
+    input.read(block->data.data() + carry.size(),
+               block->data.size() - carry.size());
+    end_of_input = !input;
+    const std::string_view text(block->data.data(),
+                                carry.size() + input.gcount());
+    size_t parsed_size = text.size();
+    if (!end_of_input) {
+      const auto last_line_end = text.rfind('\n');
+      parsed_size = last_line_end == std::string_view::npos ? 0
+                                                            : last_line_end + 1;
+    }
+    carry.assign(text.begin() + parsed_size, text.end());
+    try {
+      ParseRecords(text.substr(0, parsed_size), *block, line_number);
+    } catch (...) {
+      // The records before the invalid one are still added.
+      pipeline.PushFilled(block);
+      throw;
+    }
+    pipeline.PushFilled(block);
+  }
+}
+
+}  // namespace
+
+size_t LoadDocuments(std::istream& input, SearchServerBase& search_server,
+                     size_t max_pending_blocks) {
+  BlockPipeline pipeline(std::max<size_t>(max_pending_blocks, 1) + 1);
+  std::thread reader([&input, &pipeline] {
+    try {
+      ReadBlocks(input, pipeline);
+      pipeline.Finish(nullptr);
+    } catch (...) {
+      pipeline.Finish(std::current_exception());
+    }
+  });
+  size_t loaded = 0;
+  std::vector<int> ratings;
+  try {
+    while (RecordBlock* block = pipeline.PopFilled()) {
+      for (const DocumentRecord& record : block->records) {
+        ratings.assign(block->ratings.begin() + record.ratings_begin,
+                       block->ratings.begin() + record.ratings_end);
+        search_server.AddDocument(record.id, record.text, record.status,
+                                  ratings);
+        ++loaded;
+      }
+      pipeline.Release(block);
+    }
+  } catch (...) {
+    pipeline.Stop();
+    reader.join();
+    throw;
+  }
+  reader.join();
+  return loaded;
+}
@@ -1,8 +1,21 @@
 #pragma once
+#include <istream>
 #include <string>
 
 #include "document.h"
 
+class SearchServerBase;
+
 std::string ReadLine();
 
-int ReadLineWithNumber();
\ No newline at end of file
+int ReadLineWithNumber();
+
+// Reads "id status ratings text" records, one per line, and adds them to
+// search_server. status is a DocumentStatus name or number, ratings is a
+// comma-separated list or "-" when there are none. The input is read in
+// large blocks and parsed on a separate thread, at most max_pending_blocks
+// ahead of indexing. Returns the number of added documents. An invalid
+// record throws std::invalid_argument after the records before it are
+// added.
+size_t LoadDocuments(std::istream& input, SearchServerBase& search_server,
+                     size_t max_pending_blocks = 4);
@@ -0,0 +1,68 @@
+#pragma once
+#include <cmath>
+#include <cstddef>
+
+struct CollectionStats {
+  double document_count = 0.0;
+  double average_document_length = 0.0;
+};
+
+// Scoring policies for SearchServer::FindTopDocuments. PrepareTerm is
+// called once per query word, Score once per posting of that word, with the
+// word's share of the document (term frequency) and the document length.
+
+struct TfIdfScorer {
+  double PrepareTerm(const CollectionStats& collection,
+                     size_t document_freq) const {
+    return std::log(collection.document_count / document_freq);
+  }
+
+  double Score(double inverse_document_freq, double term_freq,
+               int /*document_length*/) const {
+    return term_freq * inverse_document_freq;
+  }
+};
+
+struct Bm25Scorer {
+  double k1 = 1.2;
+  double b = 0.75;
+
+  struct Term {
+    double inverse_document_freq;
+    double length_base;
+    double length_factor;
+  };
+
+  Term PrepareTerm(const CollectionStats& collection,
+                   size_t document_freq) const {
+    const double inverse_document_freq =
+        std::log(1.0 + (collection.document_count - document_freq + 0.5) /
+                           (document_freq + 0.5));
+    const double length_factor =
+        collection.average_document_length > 0.0
+            ? k1 * b / collection.average_document_length
+            : 0.0;
+    return {inverse_document_freq, k1 * (1.0 - b), length_factor};
+  }
+
+  double Score(const Term& term, double term_freq,
+               int document_length) const {
+    const double count = term_freq * document_length;
+    return term.inverse_document_freq * count * (k1 + 1.0) /
+           (count + term.length_base + term.length_factor * document_length);
+  }
+};
+
+// Ranks by the rarity of the matched words only, ignoring how often they
+// occur in the document.
+struct IdfScorer {
+  double PrepareTerm(const CollectionStats& collection,
+                     size_t document_freq) const {
+    return std::log(collection.document_count / document_freq);
+  }
+
+  double Score(double inverse_document_freq, double /*term_freq*/,
+               int /*document_length*/) const {
+    return inverse_document_freq;
+  }
+};
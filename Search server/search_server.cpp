@@ -1,59 +1,341 @@
 #include "search_server.h"
 
-#include <numeric>
+SearchServerBase::SearchServerBase(const SearchServerBase& other)
+    : tokenizer_(other.tokenizer_),
+      stop_words_(other.stop_words_),
+      index_mode_(other.index_mode_),
+      proximity_weight_(other.proximity_weight_),
+      max_fuzzy_edits_(other.max_fuzzy_edits_),
+      fuzzy_penalty_(other.fuzzy_penalty_),
+      query_memory_limit_(other.query_memory_limit_),
+      word_to_document_freqs_(other.word_to_document_freqs_),
+      term_dictionary_(other.term_dictionary_),
+      field_names_(other.field_names_),
+      field_word_to_document_freqs_(other.field_word_to_document_freqs_.size()),
+      document_field_starts_(other.document_field_starts_),
+      documents_(other.documents_),
+      document_ids_(other.document_ids_),
+      total_word_count_(other.total_word_count_),
+      has_attribute_index_(other.has_attribute_index_),
+      attribute_document_ids_(other.attribute_document_ids_),
+      document_ratings_(other.document_ratings_),
+      document_statuses_(other.document_statuses_),
+      document_word_counts_(other.document_word_counts_),
+      status_bitmaps_(other.status_bitmaps_),
+      rating_bitmaps_(other.rating_bitmaps_),
+      document_store_(other.document_store_) {
+  for (const auto& [word, document_positions] :
+       other.word_to_document_positions_) {
+    word_to_document_positions_.emplace_hint(
+        word_to_document_positions_.end(), GetStoredWord(word),
+        document_positions);
+  }
+  for (size_t i = 0; i < field_names_.size(); ++i) {
+    auto& word_to_document_freqs = field_word_to_document_freqs_[i];
+    for (const auto& [word, document_freqs] :
+         other.field_word_to_document_freqs_[i]) {
+      word_to_document_freqs.emplace_hint(word_to_document_freqs.end(),
+                                          GetStoredWord(word), document_freqs);
+    }
+  }
+}
+
+SearchServerBase& SearchServerBase::operator=(const SearchServerBase& other) {
+  if (this != &other) {
+    *this = SearchServerBase(other);
+  }
+  return *this;
+}
+
+void SearchServerBase::AddDocument(int document_id, std::string_view document,
+                                   DocumentStatus status,
+                                   const std::vector<int>& ratings) {
+  IndexDocument(document_id, document, {{{}, document}}, status, ratings);
+}
+
+void SearchServerBase::AddDocument(int document_id,
+                                   const std::vector<DocumentField>& fields,
+                                   DocumentStatus status,
+                                   const std::vector<int>& ratings) {
+  std::string document;
+  for (const DocumentField& field : fields) {
+    if (field.name.empty()) {
+      throw std::invalid_argument("Field name is empty"s);
+    }
+    if (!document.empty()) {
+      document += ' ';
+    }
+    document.append(field.text);
+  }
+  IndexDocument(document_id, document, fields, status, ratings);
+}
 
-void SearchServer::AddDocument(int document_id, const std::string& document,
-                               DocumentStatus status,
-                               const std::vector<int>& ratings) {
+void SearchServerBase::IndexDocument(int document_id, std::string_view text,
+                                     const std::vector<DocumentField>& fields,
+                                     DocumentStatus status,
+                                     const std::vector<int>& ratings) {
   if ((document_id < 0) || (documents_.count(document_id) > 0)) {
     throw std::invalid_argument("Invalid document_id"s);
   }
-  const auto words = SplitIntoWordsNoStop(document);
+  const bool has_positions = index_mode_ == IndexMode::POSITIONS;
+  std::vector<std::string> buffers(fields.size());
+  std::vector<std::string_view> words;
+  // End of the words of each field in words.
+  std::vector<size_t> field_ends;
+  std::vector<uint32_t> positions;
+  std::vector<uint32_t> field_starts;
+  uint32_t text_position = 0;
+  for (size_t i = 0; i < fields.size(); ++i) {
+    const std::string_view field_text =
+        NormalizeText(fields[i].text, buffers[i]);
+    std::vector<uint32_t> field_positions;
+    const auto field_words = SplitIntoWordsNoStop(
+        field_text, has_positions ? &field_positions : nullptr);
+    words.insert(words.end(), field_words.begin(), field_words.end());
+    field_ends.push_back(words.size());
+    if (!has_positions) {
+      continue;
+    }
+    if (i > 0) {
+      field_starts.push_back(text_position);
+    }
+    // Keeps phrases and proximity from spanning two fields.
+    const uint32_t field_offset = text_position + i * FIELD_POSITION_GAP;
+    for (const uint32_t position : field_positions) {
+      positions.push_back(field_offset + position);
+    }
+    ForEachWord(field_text, [&text_position](std::string_view) {
+      ++text_position;
+    });
+  }
   const double inv_word_count = 1.0 / words.size();
-  for (const std::string& word : words) {
-    word_to_document_freqs_[word][document_id] += inv_word_count;
+  for (const std::string_view word : words) {
+    auto word_it = word_to_document_freqs_.find(word);
+    if (word_it == word_to_document_freqs_.end()) {
+      word_it = word_to_document_freqs_.emplace(std::string(word),
+                                                std::map<int, double>{})
+                    .first;
+      term_dictionary_.dictionary.reset();
+    }
+    word_it->second[document_id] += inv_word_count;
+  }
+  for (size_t i = 0; i < fields.size(); ++i) {
+    if (fields[i].name.empty()) {
+      continue;
+    }
+    auto& word_to_document_freqs =
+        field_word_to_document_freqs_[GetFieldIndex(fields[i].name)];
+    for (size_t j = i > 0 ? field_ends[i - 1] : 0; j < field_ends[i]; ++j) {
+      word_to_document_freqs[GetStoredWord(words[j])][document_id] +=
+          inv_word_count;
+    }
   }
-  documents_.emplace(document_id,
-                     DocumentData{ComputeAverageRating(ratings), status});
+  if (has_positions) {
+    IndexPositions(document_id, words, positions);
+    if (!field_starts.empty()) {
+      document_field_starts_.emplace(document_id, std::move(field_starts));
+    }
+  }
+  const DocumentData document_data{ComputeAverageRating(ratings), status,
+                                   static_cast<int>(words.size())};
+  documents_.emplace(document_id, document_data);
   document_ids_.push_back(document_id);
+  if (has_attribute_index_) {
+    IndexAttributes(document_id, document_data);
+  }
+  if (document_store_) {
+    document_store_->Add(document_id, text);
+  }
+  total_word_count_ += words.size();
+}
+
+void SearchServerBase::SetProximityWeight(double weight) {
+  if (index_mode_ != IndexMode::POSITIONS) {
+    throw std::invalid_argument(
+        "Proximity ranking requires IndexMode::POSITIONS"s);
+  }
+  proximity_weight_ = weight;
 }
 
-std::vector<Document> SearchServer::FindTopDocuments(
-    const std::string& raw_query, DocumentStatus status) const {
-  return FindTopDocuments(
-      raw_query, [status](int document_id, DocumentStatus document_status,
-                          int rating) { return document_status == status; });
+void SearchServerBase::SetFuzzyMatching(int max_edits, double penalty) {
+  if (max_edits < 0 || max_edits > 2) {
+    throw std::invalid_argument("Fuzzy matching allows 0 to 2 edits"s);
+  }
+  if (!(penalty > 0.0 && penalty <= 1.0)) {
+    throw std::invalid_argument("Fuzzy penalty must be in (0, 1]"s);
+  }
+  max_fuzzy_edits_ = max_edits;
+  fuzzy_penalty_ = penalty;
 }
 
-std::vector<Document> SearchServer::FindTopDocuments(
-    const std::string& raw_query) const {
-  return FindTopDocuments(raw_query, DocumentStatus::ACTUAL);
+void SearchServerBase::SetQueryMemoryLimit(size_t bytes) {
+  query_memory_limit_ = bytes;
 }
 
-int SearchServer::GetDocumentCount() const { return documents_.size(); }
+void SearchServerBase::EnableAttributeIndex() {
+  if (has_attribute_index_) {
+    return;
+  }
+  has_attribute_index_ = true;
+  attribute_document_ids_.reserve(documents_.size());
+  document_ratings_.reserve(documents_.size());
+  document_statuses_.reserve(documents_.size());
+  document_word_counts_.reserve(documents_.size());
+  for (const auto& [document_id, document_data] : documents_) {
+    IndexAttributes(document_id, document_data);
+  }
+}
+
+DocumentBitmap SearchServerBase::SelectByStatus(DocumentStatus status) const {
+  CheckAttributeIndex();
+  return status_bitmaps_.at(static_cast<size_t>(status));
+}
+
+DocumentBitmap SearchServerBase::SelectByRating(int min_rating,
+                                                int max_rating) const {
+  CheckAttributeIndex();
+  DocumentBitmap result;
+  if (min_rating > max_rating) {
+    return result;
+  }
+  const size_t first_bucket = GetRatingBucket(min_rating);
+  const size_t last_bucket = GetRatingBucket(max_rating);
+  for (size_t bucket = first_bucket + 1; bucket < last_bucket; ++bucket) {
+    result |= rating_bitmaps_[bucket];
+  }
+  // The edge buckets may hold ratings out of range, so their documents are
+  // checked one by one.
+  for (const size_t bucket : {first_bucket, last_bucket}) {
+    DocumentBitmap matches;
+    AttributeReader attributes(*this);
+    rating_bitmaps_[bucket].ForEach([&](int document_id) {
+      const int rating = attributes.Read(document_id).rating;
+      if (rating >= min_rating && rating <= max_rating) {
+        matches.Add(document_id);
+      }
+    });
+    result |= matches;
+    if (first_bucket == last_bucket) {
+      break;
+    }
+  }
+  return result;
+}
 
-int SearchServer::GetDocumentId(int index) const {
+void SearchServerBase::EnableDocumentStore() {
+  if (!documents_.empty()) {
+    throw std::logic_error(
+        "Document store must be enabled before adding documents"s);
+  }
+  document_store_.emplace();
+}
+
+std::string SearchServerBase::GetDocumentText(int document_id) const {
+  return GetDocumentStore().Get(document_id);
+}
+
+std::vector<std::string> SearchServerBase::GetDocumentTexts(
+    const std::vector<Document>& documents) const {
+  std::vector<int> document_ids;
+  document_ids.reserve(documents.size());
+  for (const Document& document : documents) {
+    document_ids.push_back(document.id);
+  }
+  return GetDocumentStore().Get(document_ids);
+}
+
+std::string SearchServerBase::GetSnippet(int document_id,
+                                         const std::string& raw_query) const {
+  const std::string original_text = GetDocumentText(document_id);
+  std::string buffer;
+  const std::string_view text = NormalizeText(original_text, buffer);
+  QueryArena arena;
+  const auto query = ParseQuery(raw_query, arena.Resource());
+  const auto match_positions =
+      FindMatchPositions(query, document_id, text, arena.Resource());
+  // Start of the window of SNIPPET_WORD_COUNT words with the most matches.
+  uint32_t first_position = 0;
+  size_t best_match_count = 0;
+  for (size_t first = 0, last = 0; first < match_positions.size(); ++first) {
+    while (last < match_positions.size() &&
+           match_positions[last] - match_positions[first] <
+               SNIPPET_WORD_COUNT) {
+      ++last;
+    }
+    if (last - first > best_match_count) {
+      best_match_count = last - first;
+      first_position = match_positions[first];
+    }
+  }
+  const uint32_t end_position = first_position + SNIPPET_WORD_COUNT;
+  std::string snippet = first_position > 0 ? "..."s : ""s;
+  auto match_it = std::lower_bound(match_positions.begin(),
+                                   match_positions.end(), first_position);
+  uint32_t position = 0;
+  ForEachWord(text, [&](std::string_view normalized_word) {
+    if (position >= first_position && position < end_position) {
+      // Normalization keeps offsets, so the word can be shown as written.
+      const std::string_view word(
+          original_text.data() + (normalized_word.data() - text.data()),
+          normalized_word.size());
+      const bool is_match =
+          match_it != match_positions.end() && *match_it == position;
+      if (!snippet.empty()) {
+        snippet += ' ';
+      }
+      if (is_match) {
+        snippet.append("[").append(word).append("]");
+        ++match_it;
+      } else {
+        snippet.append(word);
+      }
+    } else if (position == end_position) {
+      snippet += " ..."s;
+    }
+    ++position;
+  });
+  return snippet;
+}
+
+int SearchServerBase::GetDocumentCount() const { return documents_.size(); }
+
+int SearchServerBase::GetDocumentId(int index) const {
   return document_ids_.at(index);
 }
 
 std::tuple<std::vector<std::string>, DocumentStatus>
-SearchServer::MatchDocument(const std::string& raw_query,
-                            int document_id) const {
-  const auto query = ParseQuery(raw_query);
+SearchServerBase::MatchDocument(const std::string& raw_query,
+                                int document_id) const {
+  QueryArena arena;
+  const auto query = ParseQuery(raw_query, arena.Resource());
   std::vector<std::string> matched_words;
-  for (const std::string& word : query.plus_words) {
-    if (word_to_document_freqs_.count(word) == 0) {
+  for (const std::string_view word : query.plus_words) {
+    const auto word_it = word_to_document_freqs_.find(word);
+    if (word_it == word_to_document_freqs_.end()) {
       continue;
     }
-    if (word_to_document_freqs_.at(word).count(document_id)) {
-      matched_words.push_back(word);
+    if (word_it->second.count(document_id)) {
+      matched_words.push_back(word_it->first);
     }
   }
-  for (const std::string& word : query.minus_words) {
-    if (word_to_document_freqs_.count(word) == 0) {
+  for (const auto& [word, _] : query.fuzzy_words) {
+    if (word_to_document_freqs_.find(word)->second.count(document_id)) {
+      matched_words.emplace_back(word);
+    }
+  }
+  for (const std::string_view word : query.minus_words) {
+    const auto word_it = word_to_document_freqs_.find(word);
+    if (word_it == word_to_document_freqs_.end()) {
       continue;
     }
-    if (word_to_document_freqs_.at(word).count(document_id)) {
+    if (word_it->second.count(document_id)) {
+      matched_words.clear();
+      break;
+    }
+  }
+  PositionCursors cursors(arena.Resource());
+  for (const Phrase& phrase : query.phrases) {
+    if (!ContainsPhrase(phrase, document_id, cursors)) {
       matched_words.clear();
       break;
     }
@@ -61,59 +343,205 @@ SearchServer::MatchDocument(const std::string& raw_query,
   return {matched_words, documents_.at(document_id).status};
 }
 
-bool SearchServer::IsStopWord(const std::string& word) const {
-  return stop_words_.count(word) > 0;
-}
-
-bool SearchServer::IsValidWord(const std::string& word) {
-  return none_of(word.begin(), word.end(),
-                 [](char c) { return c >= '\0' && c < ' '; });
+const DocumentStore& SearchServerBase::GetDocumentStore() const {
+  if (!document_store_) {
+    throw std::logic_error("Document store is not enabled"s);
+  }
+  return *document_store_;
 }
 
-std::vector<std::string> SearchServer::SplitIntoWordsNoStop(
-    const std::string& text) const {
-  std::vector<std::string> words;
-  for (const std::string& word : SplitIntoWords(text)) {
-    if (!IsValidWord(word)) {
-      throw std::invalid_argument("Word "s + word + " is invalid"s);
+std::pmr::vector<uint32_t> SearchServerBase::FindMatchPositions(
+    const Query& query, int document_id, std::string_view text,
+    std::pmr::memory_resource* resource) const {
+  std::pmr::vector<uint32_t> positions(resource);
+  if (index_mode_ != IndexMode::POSITIONS) {
+    uint32_t position = 0;
+    ForEachWord(text, [&query, &positions, &position](std::string_view word) {
+      if (query.plus_words.count(word) > 0 ||
+          query.fuzzy_words.count(word) > 0) {
+        positions.push_back(position);
+      }
+      ++position;
+    });
+    return positions;
+  }
+  const auto add_positions = [this, document_id,
+                              &positions](std::string_view word) {
+    const auto word_it = word_to_document_positions_.find(word);
+    if (word_it == word_to_document_positions_.end()) {
+      return;
     }
-    if (!IsStopWord(word)) {
-      words.push_back(word);
+    const auto document_it = word_it->second.find(document_id);
+    if (document_it == word_it->second.end()) {
+      return;
     }
+    PositionReader reader(document_it->second);
+    for (uint32_t position; reader.Next(position);) {
+      positions.push_back(position);
+    }
+  };
+  for (const std::string_view word : query.plus_words) {
+    add_positions(word);
   }
-  return words;
+  for (const auto& [word, _] : query.fuzzy_words) {
+    add_positions(word);
+  }
+  std::sort(positions.begin(), positions.end());
+  // Takes the gaps between fields out of the positions.
+  const auto starts_it = document_field_starts_.find(document_id);
+  if (starts_it != document_field_starts_.end()) {
+    const std::vector<uint32_t>& field_starts = starts_it->second;
+    size_t field = 0;
+    for (uint32_t& position : positions) {
+      while (field < field_starts.size() &&
+             position >=
+                 field_starts[field] + (field + 1) * FIELD_POSITION_GAP) {
+        ++field;
+      }
+      position -= field * FIELD_POSITION_GAP;
+    }
+  }
+  return positions;
 }
 
-int SearchServer::ComputeAverageRating(const std::vector<int>& ratings) {
-  if (ratings.empty()) {
-    return 0;
+void SearchServerBase::IndexAttributes(int document_id,
+                                       const DocumentData& document_data) {
+  const auto position =
+      std::lower_bound(attribute_document_ids_.begin(),
+                       attribute_document_ids_.end(), document_id) -
+      attribute_document_ids_.begin();
+  attribute_document_ids_.insert(attribute_document_ids_.begin() + position,
+                                 document_id);
+  document_ratings_.insert(document_ratings_.begin() + position,
+                           document_data.rating);
+  document_statuses_.insert(document_statuses_.begin() + position,
+                            document_data.status);
+  document_word_counts_.insert(document_word_counts_.begin() + position,
+                               document_data.word_count);
+  status_bitmaps_.at(static_cast<size_t>(document_data.status))
+      .Add(document_id);
+  rating_bitmaps_[GetRatingBucket(document_data.rating)].Add(document_id);
+}
+
+void SearchServerBase::CheckAttributeIndex() const {
+  if (!has_attribute_index_) {
+    throw std::logic_error("Attribute index is not enabled"s);
+  }
+}
+
+size_t SearchServerBase::GetRatingBucket(int rating) {
+  constexpr size_t ZERO_BUCKET = RATING_BUCKET_COUNT / 2;
+  if (rating == 0) {
+    return ZERO_BUCKET;
+  }
+  uint32_t magnitude = rating > 0 ? static_cast<uint32_t>(rating)
+                                  : 0u - static_cast<uint32_t>(rating);
+  size_t log = 0;
+  while (magnitude >>= 1) {
+    ++log;
   }
-  int rating_sum = std::accumulate(begin(ratings), end(ratings), 0);
-  return rating_sum / static_cast<int>(ratings.size());
+  return rating > 0 ? ZERO_BUCKET + 1 + log : ZERO_BUCKET - 1 - log;
 }
 
-SearchServer::QueryWord SearchServer::ParseQueryWord(
-    const std::string& text) const {
-  if (text.empty()) {
-    throw std::invalid_argument("Query word is empty"s);
+SearchServerBase::DocumentData SearchServerBase::AttributeReader::Read(
+    int document_id) {
+  if (!server_.has_attribute_index_) {
+    return server_.documents_.at(document_id);
   }
-  std::string word = text;
-  bool is_minus = false;
-  if (word[0] == '-') {
-    is_minus = true;
-    word = word.substr(1);
+  const auto& ids = server_.attribute_document_ids_;
+  if (position_ < ids.size() && ids[position_] > document_id) {
+    position_ = 0;
   }
-  if (word.empty() || word[0] == '-' || !IsValidWord(word)) {
-    throw std::invalid_argument("Query word "s + text + " is invalid");
+  position_ = GallopLowerBound(ids.begin() + position_, ids.end(),
+                               document_id) -
+              ids.begin();
+  if (position_ == ids.size() || ids[position_] != document_id) {
+    throw std::out_of_range("Unknown document_id"s);
   }
-  return {word, is_minus, IsStopWord(word)};
+  return {server_.document_ratings_[position_],
+          server_.document_statuses_[position_],
+          server_.document_word_counts_[position_]};
 }
 
-SearchServer::Query SearchServer::ParseQuery(const std::string& text) const {
-  Query result;
-  for (const std::string& word : SplitIntoWords(text)) {
-    const auto query_word = ParseQueryWord(word);
-    if (!query_word.is_stop) {
+std::string_view SearchServerBase::NormalizeText(std::string_view text,
+                                            std::string& buffer) const {
+  if (tokenizer_.IsIdentity()) {
+    return text;
+  }
+  buffer.resize(text.size());
+  tokenizer_.Normalize(text, buffer.data());
+  return buffer;
+}
+
+std::string_view SearchServerBase::GetStoredWord(std::string_view word) const {
+  return word_to_document_freqs_.find(word)->first;
+}
+
+std::vector<std::string_view> SearchServerBase::SplitIntoWordsNoStop(
+    std::string_view text, std::vector<uint32_t>* positions) const {
+  std::vector<std::string_view> words;
+  ForEachWordNoStop(text, stop_words_,
+                    [&words, positions](std::string_view word,
+                                        uint32_t position) {
+                      words.push_back(word);
+                      if (positions) {
+                        positions->push_back(position);
+                      }
+                    });
+  return words;
+}
+
+void SearchServerBase::IndexPositions(
+    int document_id, const std::vector<std::string_view>& words,
+    const std::vector<uint32_t>& positions) {
+  std::map<std::string_view, std::vector<uint32_t>> word_positions;
+  for (size_t i = 0; i < words.size(); ++i) {
+    word_positions[words[i]].push_back(positions[i]);
+  }
+  for (const auto& [word, document_positions] : word_positions) {
+    word_to_document_positions_[GetStoredWord(word)][document_id] =
+        EncodePositions(document_positions);
+  }
+}
+
+SearchServerBase::Query SearchServerBase::ParseQuery(
+    std::string_view text, std::pmr::memory_resource* resource,
+    const QueryInterrupt* interrupt) const {
+  const QueryPoller poller(interrupt);
+  if (!tokenizer_.IsIdentity() && !text.empty()) {
+    // Allocated from resource, since the query keeps views into the text.
+    auto* normalized = static_cast<char*>(resource->allocate(text.size(), 1));
+    tokenizer_.NormalizeQuery(text, normalized);
+    text = std::string_view(normalized, text.size());
+  }
+  Query result(resource);
+  while (true) {
+    const auto word_begin = text.find_first_not_of(' ');
+    if (word_begin == std::string_view::npos) {
+      break;
+    }
+    text.remove_prefix(word_begin);
+    if (text[0] == '"') {
+      const auto phrase_end = text.find('"', 1);
+      if (phrase_end == std::string_view::npos) {
+        throw std::invalid_argument("Phrase "s + std::string(text) +
+                                    " is not closed"s);
+      }
+      ParsePhrase(text.substr(1, phrase_end - 1), result);
+      text.remove_prefix(phrase_end + 1);
+      continue;
+    }
+    const auto word_end = std::min(text.find(' '), text.size());
+    const auto query_word =
+        ParseQueryWord(text.substr(0, word_end), stop_words_);
+    text.remove_prefix(word_end);
+    if (query_word.data.size() > 1 && query_word.data.back() == '*') {
+      const auto prefix = query_word.data.substr(0, query_word.data.size() - 1);
+      poller.Check();
+      ExpandPrefix(prefix,
+                   query_word.is_minus ? result.minus_words : result.plus_words,
+                   resource);
+    } else if (!query_word.is_stop) {
       if (query_word.is_minus) {
         result.minus_words.insert(query_word.data);
       } else {
@@ -121,11 +549,292 @@ SearchServer::Query SearchServer::ParseQuery(const std::string& text) const {
       }
     }
   }
+  if (max_fuzzy_edits_ > 0) {
+    for (const std::string_view word : result.plus_words) {
+      if (word_to_document_freqs_.count(word) == 0) {
+        poller.Check();
+        ExpandFuzzy(word, result, resource, interrupt);
+      }
+    }
+  }
   return result;
 }
 
-double SearchServer::ComputeWordInverseDocumentFreq(
-    const std::string& word) const {
-  return log(GetDocumentCount() * 1.0 /
-             word_to_document_freqs_.at(word).size());
+void SearchServerBase::ParsePhrase(std::string_view text, Query& query) const {
+  Phrase phrase(query.phrases.get_allocator());
+  uint32_t offset = 0;
+  ForEachWord(text, [this, &query, &phrase, &offset](std::string_view word) {
+    const auto query_word = ParseQueryWord(word, stop_words_);
+    if (query_word.is_minus) {
+      throw std::invalid_argument("Minus word "s + std::string(word) +
+                                  " inside a phrase"s);
+    }
+    if (!query_word.is_stop) {
+      query.plus_words.insert(query_word.data);
+      phrase.push_back({query_word.data, offset});
+    }
+    ++offset;
+  });
+  if (phrase.size() < 2) {
+    return;
+  }
+  if (index_mode_ != IndexMode::POSITIONS) {
+    throw std::invalid_argument("Phrase queries require IndexMode::POSITIONS"s);
+  }
+  const uint32_t first_offset = phrase.front().offset;
+  for (PhraseWord& phrase_word : phrase) {
+    phrase_word.offset -= first_offset;
+  }
+  query.phrases.push_back(std::move(phrase));
+}
+
+const TermDictionary& SearchServerBase::GetTermDictionary() const {
+  std::lock_guard lock(term_dictionary_.mutex);
+  if (!term_dictionary_.dictionary) {
+    std::vector<std::string_view> words;
+    words.reserve(word_to_document_freqs_.size());
+    term_dictionary_.words.clear();
+    term_dictionary_.words.reserve(word_to_document_freqs_.size());
+    for (auto it = word_to_document_freqs_.begin();
+         it != word_to_document_freqs_.end(); ++it) {
+      words.push_back(it->first);
+      term_dictionary_.words.push_back(it);
+    }
+    term_dictionary_.dictionary.emplace(words);
+  }
+  return *term_dictionary_.dictionary;
+}
+
+void SearchServerBase::ExpandPrefix(std::string_view prefix,
+                                    std::pmr::set<std::string_view>& words,
+                                    std::pmr::memory_resource* resource) const {
+  const TermDictionary& dictionary = GetTermDictionary();
+  int expansions = 0;
+  for (auto cursor = dictionary.LowerBound(prefix, resource);
+       cursor.IsValid() && expansions < MAX_PREFIX_EXPANSIONS;
+       cursor.Next(), ++expansions) {
+    if (cursor.GetWord().substr(0, prefix.size()) != prefix) {
+      break;
+    }
+    words.insert(term_dictionary_.words[cursor.GetOrdinal()]->first);
+  }
+}
+
+void SearchServerBase::ExpandFuzzy(std::string_view word, Query& query,
+                                   std::pmr::memory_resource* resource,
+                                   const QueryInterrupt* interrupt) const {
+  size_t length = 0;
+  for (size_t offset = 0; offset < word.size(); ++length) {
+    uint32_t code_point;
+    offset += DecodeCharacter(word, offset, code_point);
+  }
+  const int max_edits =
+      std::min(max_fuzzy_edits_, length <= 2 ? 0 : length <= 5 ? 1 : 2);
+  if (max_edits == 0) {
+    return;
+  }
+  std::pmr::vector<TermDictionary::FuzzyMatch> matches(resource);
+  GetTermDictionary().FindWithinDistance(word, max_edits, matches, resource,
+                                         interrupt);
+  const auto closer = [](const TermDictionary::FuzzyMatch& lhs,
+                         const TermDictionary::FuzzyMatch& rhs) {
+    return lhs.distance < rhs.distance;
+  };
+  const size_t match_count =
+      std::min(matches.size(), static_cast<size_t>(MAX_FUZZY_EXPANSIONS));
+  std::partial_sort(matches.begin(), matches.begin() + match_count,
+                    matches.end(), closer);
+  for (size_t i = 0; i < match_count; ++i) {
+    const std::string_view match =
+        term_dictionary_.words[matches[i].ordinal]->first;
+    if (query.plus_words.count(match) == 0) {
+      auto& weight = query.fuzzy_words[match];
+      weight = std::max(weight, std::pow(fuzzy_penalty_, matches[i].distance));
+    }
+  }
+}
+
+bool SearchServerBase::ContainsPhrase(const Phrase& phrase, int document_id,
+                                      PositionCursors& cursors) const {
+  auto& readers = cursors.readers;
+  auto& current = cursors.positions;
+  readers.clear();
+  current.assign(phrase.size(), 0);
+  for (const PhraseWord& phrase_word : phrase) {
+    const auto word_it = word_to_document_positions_.find(phrase_word.data);
+    if (word_it == word_to_document_positions_.end()) {
+      return false;
+    }
+    const auto document_it = word_it->second.find(document_id);
+    if (document_it == word_it->second.end()) {
+      return false;
+    }
+    readers.emplace_back(document_it->second);
+    if (!readers.back().Next(current[readers.size() - 1])) {
+      return false;
+    }
+  }
+  uint32_t phrase_begin = 0;
+  while (true) {
+    bool matched = true;
+    for (size_t i = 0; i < phrase.size(); ++i) {
+      const uint32_t target = phrase_begin + phrase[i].offset;
+      if (current[i] < target && !readers[i].SeekTo(target, current[i])) {
+        return false;
+      }
+      if (current[i] > target) {
+        phrase_begin = current[i] - phrase[i].offset;
+        matched = false;
+        break;
+      }
+    }
+    if (matched) {
+      return true;
+    }
+  }
+}
+
+double SearchServerBase::ComputeProximityBoost(
+    const Query& query, int document_id, PositionCursors& cursors) const {
+  auto& readers = cursors.readers;
+  auto& current = cursors.positions;
+  readers.clear();
+  current.clear();
+  for (const std::string_view word : query.plus_words) {
+    const auto word_it = word_to_document_positions_.find(word);
+    if (word_it == word_to_document_positions_.end()) {
+      continue;
+    }
+    const auto document_it = word_it->second.find(document_id);
+    if (document_it == word_it->second.end()) {
+      continue;
+    }
+    readers.emplace_back(document_it->second);
+    current.push_back(0);
+    readers.back().Next(current.back());
+  }
+  if (readers.size() < 2) {
+    return 0.0;
+  }
+  uint32_t min_distance = UINT32_MAX;
+  size_t previous_word = readers.size();
+  uint32_t previous_position = 0;
+  while (min_distance > 1) {
+    size_t next_word = readers.size();
+    for (size_t i = 0; i < readers.size(); ++i) {
+      if (current[i] != UINT32_MAX &&
+          (next_word == readers.size() || current[i] < current[next_word])) {
+        next_word = i;
+      }
+    }
+    if (next_word == readers.size()) {
+      break;
+    }
+    if (previous_word != readers.size() && previous_word != next_word) {
+      min_distance =
+          std::min(min_distance, current[next_word] - previous_position);
+    }
+    previous_word = next_word;
+    previous_position = current[next_word];
+    if (!readers[next_word].Next(current[next_word])) {
+      current[next_word] = UINT32_MAX;
+    }
+  }
+  return proximity_weight_ / min_distance;
+}
+
+bool SearchServerBase::ApplyPositionalConstraints(
+    const Query& query, int document_id, double& relevance,
+    PositionCursors& cursors) const {
+  if (index_mode_ != IndexMode::POSITIONS) {
+    return true;
+  }
+  for (const Phrase& phrase : query.phrases) {
+    if (!ContainsPhrase(phrase, document_id, cursors)) {
+      return false;
+    }
+  }
+  if (proximity_weight_ > 0.0 && query.plus_words.size() > 1) {
+    relevance += ComputeProximityBoost(query, document_id, cursors);
+  }
+  return true;
+}
+
+size_t SearchServerBase::GetFieldIndex(std::string_view name) {
+  const auto it = std::find(field_names_.begin(), field_names_.end(), name);
+  if (it != field_names_.end()) {
+    return it - field_names_.begin();
+  }
+  field_names_.emplace_back(name);
+  field_word_to_document_freqs_.emplace_back();
+  return field_names_.size() - 1;
+}
+
+void SearchServerBase::ResolveQueryPostings(
+    const Query& query, const FieldWeights& field_weights,
+    QueryPostings& postings) const {
+  WeightedFields weighted_fields(postings.fields.get_allocator());
+  for (const auto& [name, field_weight] : field_weights) {
+    const auto name_it =
+        std::find(field_names_.begin(), field_names_.end(), name);
+    if (field_weight != 1.0 && name_it != field_names_.end()) {
+      weighted_fields.emplace_back(
+          &field_word_to_document_freqs_[name_it - field_names_.begin()],
+          field_weight - 1.0);
+    }
+  }
+  for (const std::string_view word : query.plus_words) {
+    const auto word_it = word_to_document_freqs_.find(word);
+    if (word_it != word_to_document_freqs_.end()) {
+      AddWordPostings(word_it, 1.0, weighted_fields, postings);
+    }
+  }
+  for (const auto& [word, weight] : query.fuzzy_words) {
+    AddWordPostings(word_to_document_freqs_.find(word), weight,
+                    weighted_fields, postings);
+  }
+  for (const std::string_view word : query.minus_words) {
+    const auto word_it = word_to_document_freqs_.find(word);
+    if (word_it != word_to_document_freqs_.end()) {
+      postings.minus.push_back(&word_it->second);
+    }
+  }
+}
+
+void SearchServerBase::AddWordPostings(WordIndex::const_iterator word_it,
+                                       double weight,
+                                       const WeightedFields& weighted_fields,
+                                       QueryPostings& postings) const {
+  const size_t first_field = postings.fields.size();
+  for (const auto& [word_to_document_freqs, extra_weight] : weighted_fields) {
+    const auto field_word_it = word_to_document_freqs->find(word_it->first);
+    if (field_word_it != word_to_document_freqs->end()) {
+      postings.fields.push_back({field_word_it->second.begin(),
+                                 field_word_it->second.end(), extra_weight});
+    }
+  }
+  postings.plus.push_back({&word_it->second, weight, word_it->second.size(),
+                           first_field,
+                           postings.fields.size() - first_field});
+}
+
+double SearchServerBase::WeighTermFreq(int document_id, double term_freq,
+                                       FieldPostings* first,
+                                       FieldPostings* last) {
+  double weighted_freq = term_freq;
+  for (; first != last; ++first) {
+    while (first->next != first->end && first->next->first < document_id) {
+      ++first->next;
+    }
+    if (first->next != first->end && first->next->first == document_id) {
+      weighted_freq += first->extra_weight * first->next->second;
+    }
+  }
+  return weighted_freq;
+}
+
+CollectionStats SearchServerBase::GetCollectionStats() const {
+  const double document_count = GetDocumentCount();
+  return {document_count,
+          document_count > 0 ? total_word_count_ / document_count : 0.0};
 }
\ No newline at end of file
@@ -1,38 +1,122 @@
 #pragma once
 #include <algorithm>
+#include <array>
+#include <climits>
 #include <cmath>
 #include <iostream>
 #include <map>
+#include <memory_resource>
+#include <mutex>
+#include <optional>
 #include <set>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <tuple>
+#include <unordered_map>
 #include <vector>
 
+#include "document_bitmap.h"
+#include "document_store.h"
+#include "position_list.h"
+#include "query_arena.h"
+#include "query_interrupt.h"
 #include "read_input_functions.h"
+#include "scoring.h"
 #include "string_processing.h"
+#include "term_dictionary.h"
+#include "tokenizer.h"
 
 using namespace std::string_literals;
 
-class SearchServer {
+// Term frequency multipliers by field name: a word counts weight times in
+// the field before the document is scored. Unlisted fields, and documents
+// added without fields, weigh 1.
+using FieldWeights = std::map<std::string, double, std::less<>>;
+
+enum class IndexMode {
+  FREQUENCIES,
+  POSITIONS,
+};
+
+// Index and query parsing shared by every BasicSearchServer.
+class SearchServerBase {
  public:
+  // Documents, queries and stop words are normalized by tokenizer before
+  // they are split on spaces.
   template <typename StringContainer>
-  SearchServer(const StringContainer& stop_words);
+  SearchServerBase(const StringContainer& stop_words,
+                   IndexMode index_mode = IndexMode::FREQUENCIES,
+                   const Tokenizer& tokenizer = {});
+
+  SearchServerBase(const std::string& stop_words_text,
+                   IndexMode index_mode = IndexMode::FREQUENCIES,
+                   const Tokenizer& tokenizer = {})
+      : SearchServerBase(SplitIntoWords(stop_words_text), index_mode,
+                         tokenizer) {}
+
+  // Indexes keyed by views of the indexed words are re-keyed with the
+  // copy's own words.
+  SearchServerBase(const SearchServerBase& other);
+  SearchServerBase(SearchServerBase&&) = default;
 
-  SearchServer(const std::string& stop_words_text)
-      : SearchServer(SplitIntoWords(stop_words_text)) {}
+  SearchServerBase& operator=(const SearchServerBase& other);
+  SearchServerBase& operator=(SearchServerBase&&) = default;
 
-  void AddDocument(int document_id, const std::string& document,
+  void AddDocument(int document_id, std::string_view document,
                    DocumentStatus status, const std::vector<int>& ratings);
 
-  template <typename DocumentPredicate>
-  std::vector<Document> FindTopDocuments(
-      const std::string& raw_query, DocumentPredicate document_predicate) const;
+  // Indexes the fields as one text joined by spaces, and each field also
+  // under its name so queries can weigh matches by field. Phrases and
+  // proximity don't match across fields.
+  void AddDocument(int document_id, const std::vector<DocumentField>& fields,
+                   DocumentStatus status, const std::vector<int>& ratings);
 
-  std::vector<Document> FindTopDocuments(const std::string& raw_query,
-                                         DocumentStatus status) const;
+  // Keeps document attributes in arrays sorted by document id, which
+  // queries then read instead of the document map, plus bitmaps of the
+  // documents with each status and in each rating bucket for the Select*
+  // functions below.
+  void EnableAttributeIndex();
+
+  DocumentBitmap SelectByStatus(DocumentStatus status) const;
 
-  std::vector<Document> FindTopDocuments(const std::string& raw_query) const;
+  DocumentBitmap SelectByRating(int min_rating, int max_rating) const;
+
+  // Scans the attribute arrays for documents satisfying
+  // predicate(document_id, status, rating).
+  template <typename AttributePredicate>
+  DocumentBitmap SelectDocuments(AttributePredicate predicate) const;
+
+  // Keeps the text of documents added from now on in a compressed
+  // DocumentStore. Must be called before the first AddDocument.
+  void EnableDocumentStore();
+
+  std::string GetDocumentText(int document_id) const;
+
+  // Texts of found documents, in the same order.
+  std::vector<std::string> GetDocumentTexts(
+      const std::vector<Document>& documents) const;
+
+  // Up to SNIPPET_WORD_COUNT words of the document text starting at its
+  // densest cluster of query words, which are wrapped in square brackets.
+  // With IndexMode::POSITIONS the matches come from the index instead of
+  // comparing every word of the text with the query.
+  std::string GetSnippet(int document_id, const std::string& raw_query) const;
+
+  // Adds weight / (smallest distance between two different query words)
+  // to the relevance of each found document. Requires IndexMode::POSITIONS.
+  void SetProximityWeight(double weight);
+
+  // Lets a plus word that is missing from the index match indexed words
+  // up to max_edits (0 to 2) edits away. Each edit multiplies the word's
+  // contribution to relevance by penalty. Words of up to 2 characters are
+  // never corrected and words of up to 5 characters get at most one edit.
+  void SetFuzzyMatching(int max_edits, double penalty);
+
+  // Queries whose relevance table could need more than bytes (0 means no
+  // limit) are evaluated in a streaming mode that keeps only the best
+  // documents instead of a score for every match.
+  void SetQueryMemoryLimit(size_t bytes);
 
   int GetDocumentCount() const;
 
@@ -41,106 +125,660 @@ class SearchServer {
   std::tuple<std::vector<std::string>, DocumentStatus> MatchDocument(
       const std::string& raw_query, int document_id) const;
 
- private:
+ protected:
   struct DocumentData {
     int rating;
     DocumentStatus status;
+    int word_count;
+  };
+
+  using WordIndex = std::map<std::string, std::map<int, double>, std::less<>>;
+
+  // Built on the first prefix query after the set of words changes.
+  // Copies start empty because the iterators point into another index. A
+  // move takes the cache along with the index nodes its iterators point
+  // to, and leaves the source empty.
+  struct TermDictionaryCache {
+    TermDictionaryCache() = default;
+    TermDictionaryCache(const TermDictionaryCache&) {}
+
+    TermDictionaryCache(TermDictionaryCache&& other) noexcept
+        : dictionary(std::move(other.dictionary)),
+          words(std::move(other.words)) {
+      other.Reset();
+    }
+
+    TermDictionaryCache& operator=(const TermDictionaryCache&) {
+      Reset();
+      return *this;
+    }
+
+    TermDictionaryCache& operator=(TermDictionaryCache&& other) noexcept {
+      if (this != &other) {
+        dictionary = std::move(other.dictionary);
+        words = std::move(other.words);
+        other.Reset();
+      }
+      return *this;
+    }
+
+    void Reset() noexcept {
+      dictionary.reset();
+      words.clear();
+    }
+
+    std::mutex mutex;
+    std::optional<TermDictionary> dictionary;
+    std::vector<WordIndex::const_iterator> words;
   };
 
-  const double EPSILON = 1e-6;
-  const int MAX_RESULT_DOCUMENT_COUNT = 5;
-  const std::set<std::string> stop_words_;
-  std::map<std::string, std::map<int, double>> word_to_document_freqs_;
+  static constexpr int MAX_PREFIX_EXPANSIONS = 64;
+  static constexpr int MAX_FUZZY_EXPANSIONS = 16;
+  static constexpr uint32_t SNIPPET_WORD_COUNT = 12;
+  // Positions left out between two fields of a document.
+  static constexpr uint32_t FIELD_POSITION_GAP = 1024;
+  // Rating buckets hold 0 or the ratings of one sign whose magnitudes lie
+  // between two consecutive powers of two.
+  static constexpr size_t RATING_BUCKET_COUNT = 64;
+
+  Tokenizer tokenizer_;
+  std::set<std::string, std::less<>> stop_words_;
+  IndexMode index_mode_;
+  double proximity_weight_ = 0.0;
+  int max_fuzzy_edits_ = 0;
+  double fuzzy_penalty_ = 1.0;
+  size_t query_memory_limit_ = 0;
+  WordIndex word_to_document_freqs_;
+  mutable TermDictionaryCache term_dictionary_;
+  std::map<std::string_view, std::map<int, PositionList>>
+      word_to_document_positions_;
+  std::vector<std::string> field_names_;
+  using FieldWordIndex = std::map<std::string_view, std::map<int, double>>;
+  // Postings of each field, with term frequencies relative to the whole
+  // document so that they add up to the ones in word_to_document_freqs_.
+  std::vector<FieldWordIndex> field_word_to_document_freqs_;
+  // Word positions in the text where the fields after the first one start,
+  // for documents with several fields in IndexMode::POSITIONS.
+  std::map<int, std::vector<uint32_t>> document_field_starts_;
   std::map<int, DocumentData> documents_;
   std::vector<int> document_ids_;
+  size_t total_word_count_ = 0;
+  bool has_attribute_index_ = false;
+  std::vector<int> attribute_document_ids_;
+  std::vector<int> document_ratings_;
+  std::vector<DocumentStatus> document_statuses_;
+  std::vector<int> document_word_counts_;
+  std::array<DocumentBitmap, 4> status_bitmaps_;
+  std::array<DocumentBitmap, RATING_BUCKET_COUNT> rating_bitmaps_;
+  std::optional<DocumentStore> document_store_;
 
-  bool IsStopWord(const std::string& word) const;
+  // Returns text itself when the tokenizer leaves it unchanged.
+  std::string_view NormalizeText(std::string_view text,
+                                 std::string& buffer) const;
 
-  static bool IsValidWord(const std::string& word);
+  // The key of word in word_to_document_freqs_, which must contain it.
+  std::string_view GetStoredWord(std::string_view word) const;
 
-  std::vector<std::string> SplitIntoWordsNoStop(const std::string& text) const;
+  std::vector<std::string_view> SplitIntoWordsNoStop(
+      std::string_view text, std::vector<uint32_t>* positions = nullptr) const;
 
-  static int ComputeAverageRating(const std::vector<int>& ratings);
+  // Indexes the words of the fields as one document stored as text. Fields
+  // without a name aren't indexed under a field.
+  void IndexDocument(int document_id, std::string_view text,
+                     const std::vector<DocumentField>& fields,
+                     DocumentStatus status, const std::vector<int>& ratings);
 
-  struct QueryWord {
-    std::string data;
-    bool is_minus;
-    bool is_stop;
+  void IndexPositions(int document_id,
+                      const std::vector<std::string_view>& words,
+                      const std::vector<uint32_t>& positions);
+
+  struct PhraseWord {
+    std::string_view data;
+    uint32_t offset;
   };
 
-  QueryWord ParseQueryWord(const std::string& text) const;
+  using Phrase = std::pmr::vector<PhraseWord>;
 
   struct Query {
-    std::set<std::string> plus_words;
-    std::set<std::string> minus_words;
+    explicit Query(std::pmr::memory_resource* resource)
+        : plus_words(resource),
+          minus_words(resource),
+          phrases(resource),
+          fuzzy_words(resource) {}
+
+    std::pmr::set<std::string_view> plus_words;
+    std::pmr::set<std::string_view> minus_words;
+    std::pmr::vector<Phrase> phrases;
+    // Indexed words close to a missing plus word, with their weight.
+    std::pmr::map<std::string_view, double> fuzzy_words;
   };
 
-  Query ParseQuery(const std::string& text) const;
+  // interrupt, if any, is checked before each prefix or fuzzy expansion.
+  Query ParseQuery(std::string_view text, std::pmr::memory_resource* resource,
+                   const QueryInterrupt* interrupt = nullptr) const;
 
-  double ComputeWordInverseDocumentFreq(const std::string& word) const;
+  void ParsePhrase(std::string_view text, Query& query) const;
 
+  const TermDictionary& GetTermDictionary() const;
+
+  void ExpandPrefix(std::string_view prefix,
+                    std::pmr::set<std::string_view>& words,
+                    std::pmr::memory_resource* resource) const;
+
+  void ExpandFuzzy(std::string_view word, Query& query,
+                   std::pmr::memory_resource* resource,
+                   const QueryInterrupt* interrupt) const;
+
+  // Position readers of one document, reused for every document a query
+  // checks so that the query's memory doesn't grow with their number.
+  struct PositionCursors {
+    explicit PositionCursors(std::pmr::memory_resource* resource)
+        : readers(resource), positions(resource) {}
+
+    std::pmr::vector<PositionReader> readers;
+    std::pmr::vector<uint32_t> positions;
+  };
+
+  bool ContainsPhrase(const Phrase& phrase, int document_id,
+                      PositionCursors& cursors) const;
+
+  double ComputeProximityBoost(const Query& query, int document_id,
+                               PositionCursors& cursors) const;
+
+  // Returns false if the document misses a phrase of the query, otherwise
+  // adds its proximity boost to relevance.
+  bool ApplyPositionalConstraints(const Query& query, int document_id,
+                                  double& relevance,
+                                  PositionCursors& cursors) const;
+
+  CollectionStats GetCollectionStats() const;
+
+  const DocumentStore& GetDocumentStore() const;
+
+  std::pmr::vector<uint32_t> FindMatchPositions(
+      const Query& query, int document_id, std::string_view text,
+      std::pmr::memory_resource* resource) const;
+
+  void IndexAttributes(int document_id, const DocumentData& document_data);
+
+  void CheckAttributeIndex() const;
+
+  static size_t GetRatingBucket(int rating);
+
+  // Looks up document attributes, from the attribute index if there is one.
+  // Lookups in increasing id order resume where the previous one stopped.
+  class AttributeReader {
+   public:
+    explicit AttributeReader(const SearchServerBase& server)
+        : server_(server) {}
+
+    DocumentData Read(int document_id);
+
+   private:
+    const SearchServerBase& server_;
+    size_t position_ = 0;
+  };
+
+  // Passed as the predicate for a bitmap filter, which is applied by the
+  // prefilter before the document attributes are looked up.
+  struct BitmapPredicate {
+    const DocumentBitmap* filter;
+
+    bool operator()(int /*document_id*/, DocumentStatus /*status*/,
+                    int /*rating*/) const {
+      return true;
+    }
+  };
+
+  struct AllDocuments {
+    bool Contains(int /*document_id*/) const { return true; }
+  };
+
+  // Documents worth looking up for a predicate, tested in increasing id
+  // order along a posting list.
   template <typename DocumentPredicate>
-  std::vector<Document> FindAllDocuments(
-      const Query& query, DocumentPredicate document_predicate) const;
+  static AllDocuments MakePrefilter(const DocumentPredicate& /*predicate*/) {
+    return {};
+  }
+
+  static DocumentBitmap::Cursor MakePrefilter(
+      const BitmapPredicate& predicate) {
+    return DocumentBitmap::Cursor(*predicate.filter);
+  }
+
+  size_t GetFieldIndex(std::string_view name);
+
+  // Postings of a query word in a field weighing other than 1, walked
+  // along with the postings of the word.
+  struct FieldPostings {
+    std::map<int, double>::const_iterator next;
+    std::map<int, double>::const_iterator end;
+    double extra_weight;
+  };
+
+  // The postings of the word in weighted fields are the field_count
+  // FieldPostings from first_field.
+  struct WeightedPostings {
+    const std::map<int, double>* postings;
+    double weight;
+    size_t document_freq;
+    size_t first_field;
+    size_t field_count;
+  };
+
+  struct QueryPostings {
+    explicit QueryPostings(std::pmr::memory_resource* resource)
+        : plus(resource), minus(resource), fields(resource) {}
+
+    std::pmr::vector<WeightedPostings> plus;
+    std::pmr::vector<const std::map<int, double>*> minus;
+    std::pmr::vector<FieldPostings> fields;
+  };
+
+  // Postings and weight minus 1 of each weighted field of a query.
+  using WeightedFields =
+      std::pmr::vector<std::pair<const FieldWordIndex*, double>>;
+
+  void ResolveQueryPostings(const Query& query,
+                            const FieldWeights& field_weights,
+                            QueryPostings& postings) const;
+
+  void AddWordPostings(WordIndex::const_iterator word_it, double weight,
+                       const WeightedFields& weighted_fields,
+                       QueryPostings& postings) const;
+
+  // Term frequency of a word in the document with its frequency in each
+  // weighted field counted field weight times. Documents must come in
+  // increasing id order.
+  static double WeighTermFreq(int document_id, double term_freq,
+                              FieldPostings* first, FieldPostings* last);
+};
+
+struct DefaultSearchServerConfig {
+  // Number of documents FindTopDocuments returns.
+  static constexpr int MAX_RESULT_DOCUMENT_COUNT = 5;
+  // Relevances closer than this are ordered by rating instead.
+  static constexpr double EPSILON = 1e-6;
+  // Type relevance is accumulated in while a query runs.
+  using Score = double;
+  // Relevance of every matched document while a query runs.
+  using Accumulator = std::pmr::map<int, Score>;
+};
+
+// Bytes an Accumulator spends on each entry besides the entry itself,
+// used to estimate the memory of a query. The default is the color and
+// three links of a std::map node; a std::unordered_map node has a link and
+// a bucket slot.
+template <typename Accumulator>
+struct AccumulatorEntryOverhead {
+  static constexpr size_t value = 4 * sizeof(void*);
 };
 
+template <typename Key, typename Value, typename Hash, typename Equal>
+struct AccumulatorEntryOverhead<
+    std::pmr::unordered_map<Key, Value, Hash, Equal>> {
+  static constexpr size_t value = 2 * sizeof(void*);
+};
+
+// Query evaluation, specialized at compile time by Config, which provides
+// the members of DefaultSearchServerConfig.
+template <typename Config>
+class BasicSearchServer : public SearchServerBase {
+ public:
+  using SearchServerBase::SearchServerBase;
+
+  template <typename DocumentPredicate, typename Scorer = TfIdfScorer>
+  std::vector<Document> FindTopDocuments(const std::string& raw_query,
+                                         DocumentPredicate document_predicate,
+                                         const Scorer& scorer = {}) const;
+
+  // interrupt, if any, is polled while the query runs and may stop it by
+  // throwing.
+  template <typename DocumentPredicate, typename Scorer = TfIdfScorer>
+  std::vector<Document> FindTopDocuments(
+      const std::string& raw_query, const FieldWeights& field_weights,
+      DocumentPredicate document_predicate, const Scorer& scorer = {},
+      const QueryInterrupt* interrupt = nullptr) const;
+
+  std::vector<Document> FindTopDocuments(
+      const std::string& raw_query, const FieldWeights& field_weights) const {
+    return FindTopDocuments(
+        raw_query, field_weights,
+        [](int /*document_id*/, DocumentStatus status, int /*rating*/) {
+          return status == DocumentStatus::ACTUAL;
+        });
+  }
+
+  template <typename Scorer>
+  std::vector<Document> FindTopDocuments(const std::string& raw_query,
+                                         DocumentStatus status,
+                                         const Scorer& scorer) const;
+
+  std::vector<Document> FindTopDocuments(const std::string& raw_query,
+                                         DocumentStatus status) const {
+    return FindTopDocuments(raw_query, status, TfIdfScorer{});
+  }
+
+  std::vector<Document> FindTopDocuments(const std::string& raw_query) const {
+    return FindTopDocuments(raw_query, DocumentStatus::ACTUAL);
+  }
+
+  template <typename Scorer>
+  std::vector<Document> FindTopDocuments(const std::string& raw_query,
+                                         const DocumentBitmap& filter,
+                                         const Scorer& scorer) const;
+
+  // Only documents in filter are scored; the others are skipped before
+  // their attributes are looked up.
+  std::vector<Document> FindTopDocuments(const std::string& raw_query,
+                                         const DocumentBitmap& filter) const {
+    return FindTopDocuments(raw_query, filter, TfIdfScorer{});
+  }
+
+  using Score = typename Config::Score;
+
+  static constexpr size_t MAX_RESULT_DOCUMENT_COUNT =
+      Config::MAX_RESULT_DOCUMENT_COUNT;
+  static constexpr double EPSILON = Config::EPSILON;
+
+  // Order of found documents.
+  static bool IsBetter(const Document& lhs, const Document& rhs) {
+    if (std::abs(lhs.relevance - rhs.relevance) < EPSILON) {
+      return lhs.rating > rhs.rating;
+    } else {
+      return lhs.relevance > rhs.relevance;
+    }
+  }
+
+ private:
+  using Accumulator = typename Config::Accumulator;
+
+  // Entry of the accumulator with its overhead, plus the Document built
+  // from it.
+  static constexpr size_t ACCUMULATOR_BYTES_PER_DOCUMENT =
+      AccumulatorEntryOverhead<Accumulator>::value +
+      sizeof(typename Accumulator::value_type) + sizeof(Document);
+
+  template <typename DocumentPredicate, typename Scorer>
+  std::pmr::vector<Document> FindAllDocuments(
+      const Query& query, const FieldWeights& field_weights,
+      DocumentPredicate document_predicate, const Scorer& scorer,
+      QueryPoller& poller, std::pmr::memory_resource* resource) const;
+
+  // Document-at-a-time evaluation: walks the postings of all query words in
+  // document id order and keeps only the best MAX_RESULT_DOCUMENT_COUNT
+  // documents, so memory doesn't grow with the number of matches.
+  template <typename DocumentPredicate, typename Scorer>
+  std::pmr::vector<Document> FindTopDocumentsStreaming(
+      const Query& query, QueryPostings& postings,
+      DocumentPredicate document_predicate, const Scorer& scorer,
+      QueryPoller& poller, std::pmr::memory_resource* resource) const;
+
+  using SearchServerBase::ApplyPositionalConstraints;
+
+  void ApplyPositionalConstraints(const Query& query,
+                                  Accumulator& document_to_relevance,
+                                  QueryPoller& poller,
+                                  std::pmr::memory_resource* resource) const;
+};
+
+using SearchServer = BasicSearchServer<DefaultSearchServerConfig>;
+
 template <typename StringContainer>
-SearchServer::SearchServer(const StringContainer& stop_words)
-    : stop_words_(MakeUniqueNonEmptyStrings(stop_words)) {
+SearchServerBase::SearchServerBase(const StringContainer& stop_words,
+                                   IndexMode index_mode,
+                                   const Tokenizer& tokenizer)
+    : tokenizer_(tokenizer),
+      stop_words_(MakeStopWords(stop_words, tokenizer)),
+      index_mode_(index_mode) {
   if (!all_of(stop_words_.begin(), stop_words_.end(), IsValidWord)) {
     throw std::invalid_argument("Some of stop words are invalid"s);
   }
 }
 
-template <typename DocumentPredicate>
-std::vector<Document> SearchServer::FindTopDocuments(
-    const std::string& raw_query, DocumentPredicate document_predicate) const {
-  const auto query = ParseQuery(raw_query);
-  auto matched_documents = FindAllDocuments(query, document_predicate);
-  sort(matched_documents.begin(), matched_documents.end(),
-       [this](const Document& lhs, const Document& rhs) {
-         if (std::abs(lhs.relevance - rhs.relevance) < EPSILON) {
-           return lhs.rating > rhs.rating;
-         } else {
-           return lhs.relevance > rhs.relevance;
-         }
-       });
-  if (matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT) {
-    matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
+template <typename AttributePredicate>
+DocumentBitmap SearchServerBase::SelectDocuments(
+    AttributePredicate predicate) const {
+  CheckAttributeIndex();
+  DocumentBitmap result;
+  for (size_t i = 0; i < attribute_document_ids_.size(); ++i) {
+    if (predicate(attribute_document_ids_[i], document_statuses_[i],
+                  document_ratings_[i])) {
+      result.Add(attribute_document_ids_[i]);
+    }
   }
-  return matched_documents;
+  return result;
 }
 
-template <typename DocumentPredicate>
-std::vector<Document> SearchServer::FindAllDocuments(
-    const Query& query, DocumentPredicate document_predicate) const {
-  std::map<int, double> document_to_relevance;
-  for (const std::string& word : query.plus_words) {
-    if (word_to_document_freqs_.count(word) == 0) {
-      continue;
+template <typename Config>
+template <typename DocumentPredicate, typename Scorer>
+std::vector<Document> BasicSearchServer<Config>::FindTopDocuments(
+    const std::string& raw_query, DocumentPredicate document_predicate,
+    const Scorer& scorer) const {
+  return FindTopDocuments(raw_query, FieldWeights{}, document_predicate,
+                          scorer);
+}
+
+template <typename Config>
+template <typename DocumentPredicate, typename Scorer>
+std::vector<Document> BasicSearchServer<Config>::FindTopDocuments(
+    const std::string& raw_query, const FieldWeights& field_weights,
+    DocumentPredicate document_predicate, const Scorer& scorer,
+    const QueryInterrupt* interrupt) const {
+  for (const auto& [_, weight] : field_weights) {
+    if (weight < 0.0) {
+      throw std::invalid_argument("Field weights must not be negative"s);
     }
-    const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
-    for (const auto& [document_id, term_freq] :
-         word_to_document_freqs_.at(word)) {
-      const auto& document_data = documents_.at(document_id);
+  }
+  QueryArena arena;
+  const auto query = ParseQuery(raw_query, arena.Resource(), interrupt);
+  QueryPoller poller(interrupt);
+  auto matched_documents =
+      FindAllDocuments(query, field_weights, document_predicate, scorer,
+                       poller, arena.Resource());
+  std::sort(matched_documents.begin(), matched_documents.end(), IsBetter);
+  const auto result_count =
+      std::min(matched_documents.size(), MAX_RESULT_DOCUMENT_COUNT);
+  return {matched_documents.begin(),
+          matched_documents.begin() + result_count};
+}
+
+template <typename Config>
+template <typename Scorer>
+std::vector<Document> BasicSearchServer<Config>::FindTopDocuments(
+    const std::string& raw_query, DocumentStatus status,
+    const Scorer& scorer) const {
+  return FindTopDocuments(
+      raw_query,
+      [status](int /*document_id*/, DocumentStatus document_status,
+               int /*rating*/) { return document_status == status; },
+      scorer);
+}
+
+template <typename Config>
+template <typename Scorer>
+std::vector<Document> BasicSearchServer<Config>::FindTopDocuments(
+    const std::string& raw_query, const DocumentBitmap& filter,
+    const Scorer& scorer) const {
+  return FindTopDocuments(raw_query, BitmapPredicate{&filter}, scorer);
+}
+
+template <typename Config>
+template <typename DocumentPredicate, typename Scorer>
+std::pmr::vector<Document> BasicSearchServer<Config>::FindAllDocuments(
+    const Query& query, const FieldWeights& field_weights,
+    DocumentPredicate document_predicate, const Scorer& scorer,
+    QueryPoller& poller, std::pmr::memory_resource* resource) const {
+  const CollectionStats collection = GetCollectionStats();
+  QueryPostings query_postings(resource);
+  ResolveQueryPostings(query, field_weights, query_postings);
+  size_t candidate_count = 0;
+  for (const WeightedPostings& word : query_postings.plus) {
+    candidate_count += word.postings->size();
+  }
+  if (query_memory_limit_ > 0 &&
+      candidate_count * ACCUMULATOR_BYTES_PER_DOCUMENT > query_memory_limit_) {
+    return FindTopDocumentsStreaming(query, query_postings,
+                                     document_predicate, scorer, poller,
+                                     resource);
+  }
+
+  Accumulator document_to_relevance(resource);
+  for (const WeightedPostings& word : query_postings.plus) {
+    const auto term = scorer.PrepareTerm(collection, word.document_freq);
+    FieldPostings* const fields =
+        query_postings.fields.data() + word.first_field;
+    auto prefilter = MakePrefilter(document_predicate);
+    AttributeReader attributes(*this);
+    for (const auto& [document_id, term_freq] : *word.postings) {
+      poller.Poll();
+      if (!prefilter.Contains(document_id)) {
+        continue;
+      }
+      const DocumentData document_data = attributes.Read(document_id);
       if (document_predicate(document_id, document_data.status,
                              document_data.rating)) {
-        document_to_relevance[document_id] += term_freq * inverse_document_freq;
+        const double weighted_freq =
+            word.field_count == 0
+                ? term_freq
+                : WeighTermFreq(document_id, term_freq, fields,
+                                fields + word.field_count);
+        document_to_relevance[document_id] +=
+            word.weight * scorer.Score(term, weighted_freq,
+                                       document_data.word_count);
       }
     }
   }
-  for (const std::string& word : query.minus_words) {
-    if (word_to_document_freqs_.count(word) == 0) {
-      continue;
-    }
-    for (const auto& [document_id, _] : word_to_document_freqs_.at(word)) {
+  for (const auto* postings : query_postings.minus) {
+    for (const auto& [document_id, _] : *postings) {
       document_to_relevance.erase(document_id);
     }
   }
-  std::vector<Document> matched_documents;
+  ApplyPositionalConstraints(query, document_to_relevance, poller, resource);
+  std::pmr::vector<Document> matched_documents(resource);
+  matched_documents.reserve(document_to_relevance.size());
+  AttributeReader attributes(*this);
   for (const auto& [document_id, relevance] : document_to_relevance) {
     matched_documents.push_back(
-        {document_id, relevance, documents_.at(document_id).rating});
+        {document_id, relevance, attributes.Read(document_id).rating});
   }
   return matched_documents;
-}
\ No newline at end of file
+}
+
+template <typename Config>
+template <typename DocumentPredicate, typename Scorer>
+std::pmr::vector<Document>
+BasicSearchServer<Config>::FindTopDocumentsStreaming(
+    const Query& query, QueryPostings& postings,
+    DocumentPredicate document_predicate, const Scorer& scorer,
+    QueryPoller& poller, std::pmr::memory_resource* resource) const {
+  const auto& plus_postings = postings.plus;
+  const auto& minus_postings = postings.minus;
+  using PostingIterator = std::map<int, double>::const_iterator;
+  const CollectionStats collection = GetCollectionStats();
+  std::pmr::vector<decltype(scorer.PrepareTerm(collection, 1))> terms(
+      resource);
+  std::pmr::vector<PostingIterator> plus_its(resource);
+  for (const WeightedPostings& word : plus_postings) {
+    terms.push_back(scorer.PrepareTerm(collection, word.document_freq));
+    plus_its.push_back(word.postings->begin());
+  }
+  std::pmr::vector<PostingIterator> minus_its(resource);
+  for (const auto* word_postings : minus_postings) {
+    minus_its.push_back(word_postings->begin());
+  }
+  PositionCursors cursors(resource);
+  auto prefilter = MakePrefilter(document_predicate);
+  AttributeReader attributes(*this);
+  // Heap of the best documents so far, with the worst of them on top.
+  std::pmr::vector<Document> top_documents(resource);
+  top_documents.reserve(MAX_RESULT_DOCUMENT_COUNT + 1);
+  while (true) {
+    poller.Poll();
+    int document_id = INT_MAX;
+    for (size_t i = 0; i < plus_its.size(); ++i) {
+      if (plus_its[i] != plus_postings[i].postings->end()) {
+        document_id = std::min(document_id, plus_its[i]->first);
+      }
+    }
+    if (document_id == INT_MAX) {
+      break;
+    }
+    DocumentData document_data{};
+    bool is_accepted = prefilter.Contains(document_id);
+    if (is_accepted) {
+      document_data = attributes.Read(document_id);
+      is_accepted = document_predicate(document_id, document_data.status,
+                                       document_data.rating);
+    }
+    Score relevance = 0;
+    for (size_t i = 0; i < plus_its.size(); ++i) {
+      auto& it = plus_its[i];
+      if (it != plus_postings[i].postings->end() && it->first == document_id) {
+        if (is_accepted) {
+          const WeightedPostings& word = plus_postings[i];
+          FieldPostings* const fields =
+              postings.fields.data() + word.first_field;
+          const double weighted_freq =
+              word.field_count == 0
+                  ? it->second
+                  : WeighTermFreq(document_id, it->second, fields,
+                                  fields + word.field_count);
+          relevance += word.weight * scorer.Score(terms[i], weighted_freq,
+                                                  document_data.word_count);
+        }
+        ++it;
+      }
+    }
+    if (!is_accepted) {
+      continue;
+    }
+    bool is_excluded = false;
+    for (size_t i = 0; i < minus_its.size() && !is_excluded; ++i) {
+      auto& it = minus_its[i];
+      while (it != minus_postings[i]->end() && it->first < document_id) {
+        ++it;
+      }
+      is_excluded = it != minus_postings[i]->end() && it->first == document_id;
+    }
+    double boosted_relevance = relevance;
+    if (is_excluded || !ApplyPositionalConstraints(query, document_id,
+                                                   boosted_relevance,
+                                                   cursors)) {
+      continue;
+    }
+    const Document document(document_id,
+                            static_cast<Score>(boosted_relevance),
+                            document_data.rating);
+    if (top_documents.size() < MAX_RESULT_DOCUMENT_COUNT) {
+      top_documents.push_back(document);
+      std::push_heap(top_documents.begin(), top_documents.end(), IsBetter);
+    } else if (IsBetter(document, top_documents.front())) {
+      std::pop_heap(top_documents.begin(), top_documents.end(), IsBetter);
+      top_documents.back() = document;
+      std::push_heap(top_documents.begin(), top_documents.end(), IsBetter);
+    }
+  }
+  return top_documents;
+}
+
+template <typename Config>
+void BasicSearchServer<Config>::ApplyPositionalConstraints(
+    const Query& query, Accumulator& document_to_relevance,
+    QueryPoller& poller, std::pmr::memory_resource* resource) const {
+  if (index_mode_ != IndexMode::POSITIONS) {
+    return;
+  }
+  PositionCursors cursors(resource);
+  for (auto it = document_to_relevance.begin();
+       it != document_to_relevance.end();) {
+    poller.Poll();
+    double relevance = it->second;
+    if (ApplyPositionalConstraints(query, it->first, relevance, cursors)) {
+      it->second = static_cast<Score>(relevance);
+      ++it;
+    } else {
+      it = document_to_relevance.erase(it);
+    }
+  }
+}
@@ -0,0 +1,188 @@
+#include "segmented_search_server.h"
+
+SegmentedSearchServerBase::~SegmentedSearchServerBase() {
+  {
+    std::lock_guard lock(mutex_);
+    is_stopping_ = true;
+  }
+  merge_state_changed_.notify_all();
+  merge_thread_.join();
+}
+
+void SegmentedSearchServerBase::AddDocument(int document_id,
+                                            std::string_view document,
+                                            DocumentStatus status,
+                                            const std::vector<int>& ratings) {
+  std::string normalized;
+  if (!tokenizer_.IsIdentity()) {
+    normalized = tokenizer_.Normalize(document);
+    document = normalized;
+  }
+  const auto words = SplitIntoWordsNoStop(document);
+  std::lock_guard lock(mutex_);
+  if ((document_id < 0) || document_word_counts_.count(document_id) > 0 ||
+      snapshot_->deleted->count(document_id) > 0) {
+    throw std::invalid_argument("Invalid document_id"s);
+  }
+  const int word_count = static_cast<int>(words.size());
+  buffer_.AddDocument(
+      {document_id, ComputeAverageRating(ratings), status, word_count}, words);
+  document_word_counts_.emplace(document_id, word_count);
+  if (buffer_.GetDocumentCount() >= segment_document_count_) {
+    PublishBuffer();
+  }
+}
+
+void SegmentedSearchServerBase::RemoveDocument(int document_id) {
+  std::lock_guard lock(mutex_);
+  const auto word_count_it = document_word_counts_.find(document_id);
+  if (word_count_it == document_word_counts_.end()) {
+    throw std::invalid_argument("Invalid document_id"s);
+  }
+  if (buffer_.ContainsDocument(document_id)) {
+    PublishBuffer();
+  }
+  auto deleted = std::make_shared<std::unordered_set<int>>(*snapshot_->deleted);
+  deleted->insert(document_id);
+  auto snapshot = std::make_shared<Snapshot>(*snapshot_);
+  snapshot->deleted = std::move(deleted);
+  --snapshot->document_count;
+  snapshot->total_word_count -= word_count_it->second;
+  SetSnapshot(std::move(snapshot));
+  document_word_counts_.erase(word_count_it);
+}
+
+void SegmentedSearchServerBase::Flush() {
+  std::lock_guard lock(mutex_);
+  if (buffer_.GetDocumentCount() > 0) {
+    PublishBuffer();
+  }
+}
+
+void SegmentedSearchServerBase::WaitForMerges() {
+  std::unique_lock lock(mutex_);
+  merge_state_changed_.wait(lock,
+                            [this] { return !is_merging_ && !NeedsMerge(); });
+}
+
+int SegmentedSearchServerBase::GetDocumentCount() const {
+  return GetSnapshot()->document_count;
+}
+
+size_t SegmentedSearchServerBase::GetSegmentCount() const {
+  return GetSnapshot()->segments.size();
+}
+
+std::vector<std::string_view>
+SegmentedSearchServerBase::SplitIntoWordsNoStop(std::string_view text) const {
+  std::vector<std::string_view> words;
+  ForEachWordNoStop(text, stop_words_,
+                    [&words](std::string_view word, uint32_t /*position*/) {
+                      words.push_back(word);
+                    });
+  return words;
+}
+
+SegmentedSearchServerBase::Query SegmentedSearchServerBase::ParseQuery(
+    std::string_view text, std::pmr::memory_resource* resource) const {
+  if (!tokenizer_.IsIdentity() && !text.empty()) {
+    auto* normalized = static_cast<char*>(resource->allocate(text.size(), 1));
+    tokenizer_.NormalizeQuery(text, normalized);
+    text = std::string_view(normalized, text.size());
+  }
+  Query result(resource);
+  ForEachWord(text, [this, &result](std::string_view raw_word) {
+    if (raw_word.find('"') != std::string_view::npos ||
+        (raw_word.size() > 1 && raw_word.back() == '*')) {
+      throw std::invalid_argument("Word "s + std::string(raw_word) +
+                                  " uses phrase or prefix syntax"s);
+    }
+    const auto query_word = ParseQueryWord(raw_word, stop_words_);
+    if (!query_word.is_stop) {
+      (query_word.is_minus ? result.minus_words : result.plus_words)
+          .insert(query_word.data);
+    }
+  });
+  return result;
+}
+
+std::shared_ptr<const SegmentedSearchServerBase::Snapshot>
+SegmentedSearchServerBase::GetSnapshot() const {
+  std::lock_guard lock(snapshot_mutex_);
+  return snapshot_;
+}
+
+void SegmentedSearchServerBase::SetSnapshot(
+    std::shared_ptr<const Snapshot> snapshot) {
+  std::lock_guard lock(snapshot_mutex_);
+  snapshot_ = std::move(snapshot);
+}
+
+void SegmentedSearchServerBase::PublishBuffer() {
+  const int document_count = static_cast<int>(buffer_.GetDocumentCount());
+  auto segment = std::make_shared<const IndexSegment>(buffer_.Build());
+  auto snapshot = std::make_shared<Snapshot>(*snapshot_);
+  for (size_t i = 0; i < segment->GetDocumentCount(); ++i) {
+    snapshot->total_word_count += segment->GetDocument(i).word_count;
+  }
+  snapshot->document_count += document_count;
+  snapshot->segments.push_back(std::move(segment));
+  SetSnapshot(std::move(snapshot));
+  if (NeedsMerge()) {
+    merge_state_changed_.notify_all();
+  }
+}
+
+bool SegmentedSearchServerBase::NeedsMerge() const {
+  return snapshot_->segments.size() > merge_factor_;
+}
+
+void SegmentedSearchServerBase::MergeSegments() {
+  std::unique_lock lock(mutex_);
+  while (true) {
+    merge_state_changed_.wait(lock,
+                              [this] { return is_stopping_ || NeedsMerge(); });
+    if (is_stopping_) {
+      return;
+    }
+    const auto snapshot = snapshot_;
+    std::vector<const IndexSegment*> inputs;
+    for (const auto& segment : snapshot->segments) {
+      inputs.push_back(segment.get());
+    }
+    std::sort(inputs.begin(), inputs.end(),
+              [](const IndexSegment* lhs, const IndexSegment* rhs) {
+                return lhs->GetDocumentCount() < rhs->GetDocumentCount();
+              });
+    inputs.resize(merge_factor_);
+    is_merging_ = true;
+    lock.unlock();
+
+    std::vector<int> applied_deletions;
+    auto merged = std::make_shared<const IndexSegment>(
+        IndexSegment::Merge(inputs, *snapshot->deleted, applied_deletions));
+
+    lock.lock();
+    auto next = std::make_shared<Snapshot>(*snapshot_);
+    next->segments.erase(
+        std::remove_if(next->segments.begin(), next->segments.end(),
+                       [&inputs](const auto& segment) {
+                         return std::find(inputs.begin(), inputs.end(),
+                                          segment.get()) != inputs.end();
+                       }),
+        next->segments.end());
+    if (merged->GetDocumentCount() > 0) {
+      next->segments.push_back(std::move(merged));
+    }
+    if (!applied_deletions.empty()) {
+      auto deleted = std::make_shared<std::unordered_set<int>>(*next->deleted);
+      for (const int document_id : applied_deletions) {
+        deleted->erase(document_id);
+      }
+      next->deleted = std::move(deleted);
+    }
+    SetSnapshot(std::move(next));
+    is_merging_ = false;
+    merge_state_changed_.notify_all();
+  }
+}
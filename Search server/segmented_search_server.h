@@ -0,0 +1,282 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "document.h"
+#include "index_segment.h"
+#include "query_arena.h"
+#include "scoring.h"
+#include "search_server.h"
+#include "string_processing.h"
+#include "tokenizer.h"
+
+using namespace std::string_literals;
+
+// Search index made of immutable segments. New documents are buffered and
+// published as a small segment every segment_document_count documents (or
+// on Flush), so queries see a document once its segment is published. A
+// background thread merges the smallest segments whenever there are more
+// than merge_factor of them. Removed documents are hidden at once and
+// dropped from the index by the merge that covers them; until then their
+// ids can't be reused. Documents, queries and stop words are normalized by
+// tokenizer like in SearchServerBase. Queries are evaluated by
+// BasicSegmentedSearchServer.
+class SegmentedSearchServerBase {
+ public:
+  template <typename StringContainer>
+  explicit SegmentedSearchServerBase(const StringContainer& stop_words,
+                                     size_t segment_document_count = 1024,
+                                     size_t merge_factor = 4,
+                                     const Tokenizer& tokenizer = {});
+
+  explicit SegmentedSearchServerBase(const std::string& stop_words_text,
+                                     size_t segment_document_count = 1024,
+                                     size_t merge_factor = 4,
+                                     const Tokenizer& tokenizer = {})
+      : SegmentedSearchServerBase(SplitIntoWords(stop_words_text),
+                                  segment_document_count, merge_factor,
+                                  tokenizer) {}
+
+  SegmentedSearchServerBase(const SegmentedSearchServerBase&) = delete;
+  SegmentedSearchServerBase& operator=(const SegmentedSearchServerBase&) =
+      delete;
+
+  ~SegmentedSearchServerBase();
+
+  void AddDocument(int document_id, std::string_view document,
+                   DocumentStatus status, const std::vector<int>& ratings);
+
+  void RemoveDocument(int document_id);
+
+  // Publishes the buffered documents as a segment.
+  void Flush();
+
+  // Blocks until the background thread has no merge to do.
+  void WaitForMerges();
+
+  // Number of searchable documents.
+  int GetDocumentCount() const;
+
+  size_t GetSegmentCount() const;
+
+ protected:
+  // Published state. Snapshots share the segments and the set of deleted
+  // ids, which is copied only when it changes.
+  struct Snapshot {
+    std::vector<std::shared_ptr<const IndexSegment>> segments;
+    std::shared_ptr<const std::unordered_set<int>> deleted =
+        std::make_shared<const std::unordered_set<int>>();
+    int document_count = 0;
+    size_t total_word_count = 0;
+  };
+
+  struct Query {
+    explicit Query(std::pmr::memory_resource* resource)
+        : plus_words(resource), minus_words(resource) {}
+
+    std::pmr::set<std::string_view> plus_words;
+    std::pmr::set<std::string_view> minus_words;
+  };
+
+  const Tokenizer tokenizer_;
+  const std::set<std::string, std::less<>> stop_words_;
+  const size_t segment_document_count_;
+  const size_t merge_factor_;
+
+  // Serializes the writers, which build new segments while holding it, and
+  // the updates of the merge thread.
+  std::mutex mutex_;
+  std::condition_variable merge_state_changed_;
+  // Guards only reads and writes of the snapshot_ pointer, so queries
+  // don't wait for segments being built. Writers also hold mutex_, so they
+  // may read snapshot_ without it.
+  mutable std::mutex snapshot_mutex_;
+  std::shared_ptr<const Snapshot> snapshot_ = std::make_shared<Snapshot>();
+  IndexSegment::Builder buffer_;
+  // Word counts of documents that are buffered or searchable.
+  std::map<int, int> document_word_counts_;
+  bool is_merging_ = false;
+  bool is_stopping_ = false;
+  std::thread merge_thread_;
+
+  std::vector<std::string_view> SplitIntoWordsNoStop(
+      std::string_view text) const;
+
+  // Throws std::invalid_argument on phrase and prefix syntax, which only
+  // SearchServer supports.
+  Query ParseQuery(std::string_view text,
+                   std::pmr::memory_resource* resource) const;
+
+  std::shared_ptr<const Snapshot> GetSnapshot() const;
+
+  // Requires mutex_.
+  void SetSnapshot(std::shared_ptr<const Snapshot> snapshot);
+
+  void PublishBuffer();
+
+  bool NeedsMerge() const;
+
+  void MergeSegments();
+};
+
+// Query evaluation over the segments, ranking documents like
+// BasicSearchServer<Config>.
+template <typename Config>
+class BasicSegmentedSearchServer : public SegmentedSearchServerBase {
+ public:
+  using SegmentedSearchServerBase::SegmentedSearchServerBase;
+
+  template <typename DocumentPredicate, typename Scorer = TfIdfScorer>
+  std::vector<Document> FindTopDocuments(const std::string& raw_query,
+                                         DocumentPredicate document_predicate,
+                                         const Scorer& scorer = {}) const;
+
+  template <typename Scorer>
+  std::vector<Document> FindTopDocuments(const std::string& raw_query,
+                                         DocumentStatus status,
+                                         const Scorer& scorer) const;
+
+  std::vector<Document> FindTopDocuments(const std::string& raw_query,
+                                         DocumentStatus status) const {
+    return FindTopDocuments(raw_query, status, TfIdfScorer{});
+  }
+
+  std::vector<Document> FindTopDocuments(const std::string& raw_query) const {
+    return FindTopDocuments(raw_query, DocumentStatus::ACTUAL);
+  }
+
+ private:
+  using Ranking = BasicSearchServer<Config>;
+  using Score = typename Ranking::Score;
+
+  template <typename DocumentPredicate, typename Scorer>
+  std::pmr::vector<Document> FindAllDocuments(
+      const Snapshot& snapshot, const Query& query,
+      DocumentPredicate document_predicate, const Scorer& scorer,
+      std::pmr::memory_resource* resource) const;
+};
+
+using SegmentedSearchServer =
+    BasicSegmentedSearchServer<DefaultSearchServerConfig>;
+
+template <typename StringContainer>
+SegmentedSearchServerBase::SegmentedSearchServerBase(
+    const StringContainer& stop_words, size_t segment_document_count,
+    size_t merge_factor, const Tokenizer& tokenizer)
+    : tokenizer_(tokenizer),
+      stop_words_(MakeStopWords(stop_words, tokenizer)),
+      segment_document_count_(std::max<size_t>(segment_document_count, 1)),
+      merge_factor_(std::max<size_t>(merge_factor, 2)) {
+  if (!all_of(stop_words_.begin(), stop_words_.end(), IsValidWord)) {
+    throw std::invalid_argument("Some of stop words are invalid"s);
+  }
+  merge_thread_ = std::thread([this] { MergeSegments(); });
+}
+
+template <typename Config>
+template <typename DocumentPredicate, typename Scorer>
+std::vector<Document> BasicSegmentedSearchServer<Config>::FindTopDocuments(
+    const std::string& raw_query, DocumentPredicate document_predicate,
+    const Scorer& scorer) const {
+  const auto snapshot = GetSnapshot();
+  QueryArena arena;
+  const auto query = ParseQuery(raw_query, arena.Resource());
+  auto matched_documents = FindAllDocuments(
+      *snapshot, query, document_predicate, scorer, arena.Resource());
+  std::sort(matched_documents.begin(), matched_documents.end(),
+            Ranking::IsBetter);
+  const auto result_count = std::min(matched_documents.size(),
+                                     Ranking::MAX_RESULT_DOCUMENT_COUNT);
+  return {matched_documents.begin(),
+          matched_documents.begin() + result_count};
+}
+
+template <typename Config>
+template <typename Scorer>
+std::vector<Document> BasicSegmentedSearchServer<Config>::FindTopDocuments(
+    const std::string& raw_query, DocumentStatus status,
+    const Scorer& scorer) const {
+  return FindTopDocuments(
+      raw_query,
+      [status](int /*document_id*/, DocumentStatus document_status,
+               int /*rating*/) { return document_status == status; },
+      scorer);
+}
+
+template <typename Config>
+template <typename DocumentPredicate, typename Scorer>
+std::pmr::vector<Document>
+BasicSegmentedSearchServer<Config>::FindAllDocuments(
+    const Snapshot& snapshot, const Query& query,
+    DocumentPredicate document_predicate, const Scorer& scorer,
+    std::pmr::memory_resource* resource) const {
+  const double document_count = snapshot.document_count;
+  const CollectionStats collection{
+      document_count,
+      document_count > 0 ? snapshot.total_word_count / document_count : 0.0};
+  const auto& deleted = *snapshot.deleted;
+  const auto is_deleted = [&deleted](const IndexSegment::DocumentData& data) {
+    return !deleted.empty() && deleted.count(data.id) > 0;
+  };
+  struct Match {
+    Score relevance = 0;
+    int rating = 0;
+  };
+  std::pmr::map<int, Match> document_to_relevance(resource);
+  for (const std::string_view word : query.plus_words) {
+    size_t document_freq = 0;
+    for (const auto& segment : snapshot.segments) {
+      const auto [first, last] = segment->FindPostings(word);
+      for (auto posting = first; posting != last; ++posting) {
+        document_freq +=
+            !is_deleted(segment->GetDocument(posting->document_index));
+      }
+    }
+    if (document_freq == 0) {
+      continue;
+    }
+    const auto term = scorer.PrepareTerm(collection, document_freq);
+    for (const auto& segment : snapshot.segments) {
+      const auto [first, last] = segment->FindPostings(word);
+      for (auto posting = first; posting != last; ++posting) {
+        const auto& document_data =
+            segment->GetDocument(posting->document_index);
+        if (!is_deleted(document_data) &&
+            document_predicate(document_data.id, document_data.status,
+                               document_data.rating)) {
+          auto& match = document_to_relevance[document_data.id];
+          match.relevance += scorer.Score(term, posting->term_freq,
+                                          document_data.word_count);
+          match.rating = document_data.rating;
+        }
+      }
+    }
+  }
+  for (const std::string_view word : query.minus_words) {
+    for (const auto& segment : snapshot.segments) {
+      const auto [first, last] = segment->FindPostings(word);
+      for (auto posting = first; posting != last; ++posting) {
+        document_to_relevance.erase(
+            segment->GetDocument(posting->document_index).id);
+      }
+    }
+  }
+  std::pmr::vector<Document> matched_documents(resource);
+  matched_documents.reserve(document_to_relevance.size());
+  for (const auto& [document_id, match] : document_to_relevance) {
+    matched_documents.push_back({document_id, match.relevance, match.rating});
+  }
+  return matched_documents;
+}
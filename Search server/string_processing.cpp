@@ -1,5 +1,7 @@
 #include "string_processing.h"
 
+using namespace std::string_literals;
+
 std::vector<std::string> SplitIntoWords(const std::string& text) {
   std::vector<std::string> words;
   std::string word;
@@ -17,4 +19,28 @@ std::vector<std::string> SplitIntoWords(const std::string& text) {
     words.push_back(word);
   }
   return words;
-}
\ No newline at end of file
+}
+
+bool IsValidWord(std::string_view word) {
+  return std::none_of(word.begin(), word.end(),
+                      [](char c) { return c >= '\0' && c < ' '; });
+}
+
+QueryWord ParseQueryWord(
+    std::string_view text,
+    const std::set<std::string, std::less<>>& stop_words) {
+  if (text.empty()) {
+    throw std::invalid_argument("Query word is empty"s);
+  }
+  std::string_view word = text;
+  bool is_minus = false;
+  if (word[0] == '-') {
+    is_minus = true;
+    word.remove_prefix(1);
+  }
+  if (word.empty() || word[0] == '-' || !IsValidWord(word)) {
+    throw std::invalid_argument("Query word "s + std::string(text) +
+                                " is invalid"s);
+  }
+  return {word, is_minus, stop_words.count(word) > 0};
+}
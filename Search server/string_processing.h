@@ -1,18 +1,71 @@
 #pragma once
+#include <algorithm>
+#include <cstdint>
 #include <set>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 #include <vector>
 
 std::vector<std::string> SplitIntoWords(const std::string& text);
 
+template <typename Callback>
+void ForEachWord(std::string_view text, Callback callback) {
+  while (true) {
+    const auto word_begin = text.find_first_not_of(' ');
+    if (word_begin == std::string_view::npos) {
+      return;
+    }
+    text.remove_prefix(word_begin);
+    const auto word_end = std::min(text.find(' '), text.size());
+    callback(text.substr(0, word_end));
+    text.remove_prefix(word_end);
+  }
+}
+
+// Words and stop words may not contain control characters.
+bool IsValidWord(std::string_view word);
+
+// Calls callback(word, position) for each word of text that is not a stop
+// word, where position counts the stop words too. Throws
+// std::invalid_argument if a word is invalid.
+template <typename Callback>
+void ForEachWordNoStop(std::string_view text,
+                       const std::set<std::string, std::less<>>& stop_words,
+                       Callback callback) {
+  uint32_t position = 0;
+  ForEachWord(text, [&stop_words, &callback,
+                     &position](std::string_view word) {
+    if (!IsValidWord(word)) {
+      throw std::invalid_argument("Word " + std::string(word) +
+                                  " is invalid");
+    }
+    if (stop_words.count(word) == 0) {
+      callback(word, position);
+    }
+    ++position;
+  });
+}
+
+struct QueryWord {
+  std::string_view data;
+  bool is_minus;
+  bool is_stop;
+};
+
+// Parses "word" or "-word". Throws std::invalid_argument if the word is
+// empty, starts with a second minus or is invalid.
+QueryWord ParseQueryWord(std::string_view text,
+                         const std::set<std::string, std::less<>>& stop_words);
+
 template <typename StringContainer>
-std::set<std::string> MakeUniqueNonEmptyStrings(
+std::set<std::string, std::less<>> MakeUniqueNonEmptyStrings(
     const StringContainer& strings) {
-  std::set<std::string> non_empty_strings;
+  std::set<std::string, std::less<>> non_empty_strings;
   for (const std::string& str : strings) {
     if (!str.empty()) {
       non_empty_strings.insert(str);
     }
   }
   return non_empty_strings;
-}
\ No newline at end of file
+}
@@ -0,0 +1,244 @@
+#include "term_dictionary.h"
+
+#include <algorithm>
+
+#include "tokenizer.h"
+
+namespace {
+
+void AppendVarint(std::vector<uint8_t>& data, size_t value) {
+  while (value >= 0x80) {
+    data.push_back(static_cast<uint8_t>(value | 0x80));
+    value >>= 7;
+  }
+  data.push_back(static_cast<uint8_t>(value));
+}
+
+size_t ReadVarint(const uint8_t* data, size_t& offset) {
+  size_t value = 0;
+  for (int shift = 0;; shift += 7) {
+    const uint8_t byte = data[offset++];
+    value |= static_cast<size_t>(byte & 0x7F) << shift;
+    if (!(byte & 0x80)) {
+      return value;
+    }
+  }
+}
+
+}  // namespace
+
+TermDictionary::TermDictionary(const std::vector<std::string_view>& words)
+    : word_count_(words.size()) {
+  std::string_view previous;
+  for (size_t i = 0; i < words.size(); ++i) {
+    const std::string_view word = words[i];
+    size_t shared_prefix = 0;
+    if (i % BLOCK_SIZE == 0) {
+      block_offsets_.push_back(static_cast<uint32_t>(data_.size()));
+    } else {
+      const size_t max_shared = std::min(previous.size(), word.size());
+      while (shared_prefix < max_shared &&
+             previous[shared_prefix] == word[shared_prefix]) {
+        ++shared_prefix;
+      }
+    }
+    AppendVarint(data_, shared_prefix);
+    AppendVarint(data_, word.size() - shared_prefix);
+    data_.insert(data_.end(), word.begin() + shared_prefix, word.end());
+    previous = word;
+  }
+  data_.shrink_to_fit();
+}
+
+TermDictionary::Cursor TermDictionary::Begin(
+    std::pmr::memory_resource* resource) const {
+  return Cursor(*this, 0, resource);
+}
+
+TermDictionary::Cursor TermDictionary::LowerBound(
+    std::string_view word, std::pmr::memory_resource* resource) const {
+  Cursor cursor(*this, FindBlock(word), resource);
+  cursor.SkipWordsBefore(word);
+  return cursor;
+}
+
+std::string_view TermDictionary::GetBlockFirstWord(size_t block) const {
+  size_t offset = block_offsets_[block];
+  ReadVarint(data_.data(), offset);
+  const size_t size = ReadVarint(data_.data(), offset);
+  return {reinterpret_cast<const char*>(data_.data()) + offset, size};
+}
+
+size_t TermDictionary::FindBlock(std::string_view word) const {
+  size_t first = 0;
+  size_t last = block_offsets_.size();
+  while (last - first > 1) {
+    const size_t middle = first + (last - first) / 2;
+    if (GetBlockFirstWord(middle) <= word) {
+      first = middle;
+    } else {
+      last = middle;
+    }
+  }
+  return first;
+}
+
+void TermDictionary::FindWithinDistance(
+    std::string_view word, int max_edits,
+    std::pmr::vector<FuzzyMatch>& matches, std::pmr::memory_resource* resource,
+    const QueryInterrupt* interrupt) const {
+  QueryPoller poller(interrupt);
+  std::pmr::vector<uint32_t> characters(resource);
+  for (size_t offset = 0; offset < word.size();) {
+    characters.push_back(0);
+    offset += DecodeCharacter(word, offset, characters.back());
+  }
+  const size_t row_size = characters.size() + 1;
+  // rows[depth * row_size + i] is the distance between the first depth
+  // characters of the dictionary word and the first i characters of word.
+  std::pmr::vector<int> rows(row_size, 0, resource);
+  for (size_t i = 0; i < row_size; ++i) {
+    rows[i] = static_cast<int>(i);
+  }
+  std::pmr::string computed_prefix(resource);
+  // Characters of computed_prefix and the byte offsets where they end.
+  std::pmr::vector<uint32_t> prefix_characters(resource);
+  std::pmr::vector<size_t> character_ends(resource);
+  std::pmr::string next_prefix(resource);
+  Cursor cursor = Begin(resource);
+  while (cursor.IsValid()) {
+    poller.Poll();
+    const std::string_view dictionary_word = cursor.GetWord();
+    size_t shared_size = 0;
+    const size_t max_shared_size =
+        std::min(computed_prefix.size(), dictionary_word.size());
+    while (shared_size < max_shared_size &&
+           computed_prefix[shared_size] == dictionary_word[shared_size]) {
+      ++shared_size;
+    }
+    // Rows are kept for the characters of the shared bytes that decode the
+    // same in both words, which a malformed sequence might not.
+    size_t depth = 0;
+    size_t offset = 0;
+    while (depth < character_ends.size() &&
+           character_ends[depth] <= shared_size) {
+      uint32_t character;
+      const size_t length =
+          DecodeCharacter(dictionary_word, offset, character);
+      if (offset + length != character_ends[depth] ||
+          character != prefix_characters[depth]) {
+        break;
+      }
+      offset += length;
+      ++depth;
+    }
+    prefix_characters.resize(depth);
+    character_ends.resize(depth);
+    computed_prefix.resize(offset);
+    rows.resize((dictionary_word.size() + 1) * row_size);
+    bool is_dead_prefix = false;
+    while (offset < dictionary_word.size()) {
+      uint32_t character;
+      const size_t length =
+          DecodeCharacter(dictionary_word, offset, character);
+      const int* previous = rows.data() + depth * row_size;
+      int* current = rows.data() + (depth + 1) * row_size;
+      current[0] = previous[0] + 1;
+      int row_min = current[0];
+      for (size_t i = 1; i < row_size; ++i) {
+        const int substitution =
+            previous[i - 1] + (character != characters[i - 1]);
+        current[i] = std::min({previous[i] + 1, current[i - 1] + 1,
+                               substitution});
+        row_min = std::min(row_min, current[i]);
+      }
+      computed_prefix.append(dictionary_word.substr(offset, length));
+      offset += length;
+      prefix_characters.push_back(character);
+      character_ends.push_back(offset);
+      ++depth;
+      if (row_min > max_edits) {
+        is_dead_prefix = true;
+        break;
+      }
+    }
+    if (!is_dead_prefix) {
+      const int distance = rows[depth * row_size + characters.size()];
+      if (distance <= max_edits) {
+        matches.push_back({cursor.GetOrdinal(), distance});
+      }
+      cursor.Next();
+      continue;
+    }
+    // A malformed last character may decode differently in the next words.
+    if (prefix_characters.back() > 0x10FFFF) {
+      cursor.Next();
+      continue;
+    }
+    // No word starting with computed_prefix can match: jump to the first
+    // word after all of them.
+    next_prefix.assign(computed_prefix);
+    while (!next_prefix.empty() &&
+           static_cast<unsigned char>(next_prefix.back()) == 0xFF) {
+      next_prefix.pop_back();
+    }
+    if (next_prefix.empty()) {
+      return;
+    }
+    next_prefix.back() = static_cast<char>(
+        static_cast<unsigned char>(next_prefix.back()) + 1);
+    cursor.Seek(next_prefix);
+  }
+}
+
+TermDictionary::Cursor::Cursor(const TermDictionary& dictionary, size_t block,
+                               std::pmr::memory_resource* resource)
+    : dictionary_(&dictionary), word_(resource) {
+  MoveToBlock(block);
+}
+
+void TermDictionary::Cursor::Next() {
+  ++ordinal_;
+  if (!IsValid()) {
+    return;
+  }
+  const uint8_t* data = dictionary_->data_.data();
+  const size_t stored_prefix = ReadVarint(data, offset_);
+  const size_t suffix_size = ReadVarint(data, offset_);
+  const char* suffix = reinterpret_cast<const char*>(data) + offset_;
+  offset_ += suffix_size;
+  // Block starts store the whole word, so the prefix shared with the
+  // previous block is recomputed here.
+  shared_prefix_ = stored_prefix;
+  while (shared_prefix_ < word_.size() &&
+         shared_prefix_ - stored_prefix < suffix_size &&
+         word_[shared_prefix_] == suffix[shared_prefix_ - stored_prefix]) {
+    ++shared_prefix_;
+  }
+  word_.resize(stored_prefix);
+  word_.append(suffix, suffix_size);
+}
+
+void TermDictionary::Cursor::Seek(std::string_view word) {
+  MoveToBlock(dictionary_->FindBlock(word));
+  SkipWordsBefore(word);
+}
+
+void TermDictionary::Cursor::MoveToBlock(size_t block) {
+  ordinal_ = std::min(block * BLOCK_SIZE, dictionary_->word_count_);
+  offset_ = block < dictionary_->block_offsets_.size()
+                ? dictionary_->block_offsets_[block]
+                : dictionary_->data_.size();
+  shared_prefix_ = 0;
+  word_.clear();
+  if (IsValid()) {
+    --ordinal_;
+    Next();
+  }
+}
+
+void TermDictionary::Cursor::SkipWordsBefore(std::string_view word) {
+  while (IsValid() && word_ < word) {
+    Next();
+  }
+}
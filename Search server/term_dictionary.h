@@ -0,0 +1,89 @@
+#pragma once
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "query_interrupt.h"
+
+// Sorted set of words stored front-coded in blocks of BLOCK_SIZE: each word
+// keeps only the suffix it doesn't share with the previous one, and every
+// block starts with a full word so a lookup can binary search the blocks.
+class TermDictionary {
+ public:
+  static constexpr size_t BLOCK_SIZE = 16;
+
+  class Cursor {
+   public:
+    bool IsValid() const { return ordinal_ < dictionary_->word_count_; }
+
+    std::string_view GetWord() const { return word_; }
+
+    // Position of the word in sorted order.
+    size_t GetOrdinal() const { return ordinal_; }
+
+    // Length of the prefix the word shares with the previous one.
+    size_t GetSharedPrefix() const { return shared_prefix_; }
+
+    void Next();
+
+    // Moves to the first word not less than word, reusing the buffer the
+    // cursor already has.
+    void Seek(std::string_view word);
+
+   private:
+    friend class TermDictionary;
+
+    Cursor(const TermDictionary& dictionary, size_t block,
+           std::pmr::memory_resource* resource);
+
+    void MoveToBlock(size_t block);
+
+    void SkipWordsBefore(std::string_view word);
+
+    const TermDictionary* dictionary_;
+    size_t ordinal_ = 0;
+    size_t offset_ = 0;
+    size_t shared_prefix_ = 0;
+    std::pmr::string word_;
+  };
+
+  TermDictionary() = default;
+
+  // words must be sorted and unique.
+  explicit TermDictionary(const std::vector<std::string_view>& words);
+
+  size_t GetWordCount() const { return word_count_; }
+
+  Cursor Begin(std::pmr::memory_resource* resource) const;
+
+  // Cursor at the first word not less than word.
+  Cursor LowerBound(std::string_view word,
+                    std::pmr::memory_resource* resource) const;
+
+  struct FuzzyMatch {
+    size_t ordinal;
+    int distance;
+  };
+
+  // Appends every word within max_edits Levenshtein edits of word, counted
+  // in UTF-8 characters. The edit-distance rows are shared between words
+  // with a common prefix, and a prefix that is already too far away is
+  // skipped with one lookup. interrupt, if any, is polled for every word
+  // the search visits.
+  void FindWithinDistance(std::string_view word, int max_edits,
+                          std::pmr::vector<FuzzyMatch>& matches,
+                          std::pmr::memory_resource* resource,
+                          const QueryInterrupt* interrupt = nullptr) const;
+
+ private:
+  std::vector<uint8_t> data_;
+  std::vector<uint32_t> block_offsets_;
+  size_t word_count_ = 0;
+
+  std::string_view GetBlockFirstWord(size_t block) const;
+
+  // Last block whose first word is not greater than word, or 0.
+  size_t FindBlock(std::string_view word) const;
+};
@@ -0,0 +1,93 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(size_t thread_count, size_t queue_capacity)
+    : queue_capacity_(std::max<size_t>(queue_capacity, 1)) {
+  thread_count = std::max<size_t>(thread_count, 1);
+  for (size_t i = 0; i < thread_count; ++i) {
+    queues_.push_back(std::make_unique<WorkerQueue>());
+  }
+  for (size_t i = 0; i < thread_count; ++i) {
+    threads_.emplace_back([this, i] { Work(i); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard lock(mutex_);
+    is_stopping_ = true;
+  }
+  has_work_.notify_all();
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+}
+
+bool ThreadPool::TrySubmit(std::function<void()> task) {
+  if (is_stopping_) {
+    return false;
+  }
+  size_t queued = queued_.load();
+  do {
+    if (queued >= queue_capacity_) {
+      return false;
+    }
+  } while (!queued_.compare_exchange_weak(queued, queued + 1));
+  auto& queue = *queues_[next_queue_++ % queues_.size()];
+  try {
+    std::lock_guard lock(queue.mutex);
+    queue.tasks.push_back(std::move(task));
+    ++available_;
+  } catch (...) {
+    --queued_;
+    throw;
+  }
+  // A worker counted in waiting_ holds mutex_ until it waits, so the
+  // notification can't come before its wait. A worker that isn't counted
+  // yet sees available_ before it waits.
+  if (waiting_ > 0) {
+    std::lock_guard lock(mutex_);
+    has_work_.notify_one();
+  }
+  return true;
+}
+
+bool ThreadPool::TryTake(size_t index, std::function<void()>& task) {
+  for (size_t i = 0; i < queues_.size(); ++i) {
+    auto& queue = *queues_[(index + i) % queues_.size()];
+    std::lock_guard lock(queue.mutex);
+    if (queue.tasks.empty()) {
+      continue;
+    }
+    if (i == 0) {
+      task = std::move(queue.tasks.front());
+      queue.tasks.pop_front();
+    } else {
+      task = std::move(queue.tasks.back());
+      queue.tasks.pop_back();
+    }
+    --available_;
+    --queued_;
+    return true;
+  }
+  return false;
+}
+
+void ThreadPool::Work(size_t index) {
+  std::function<void()> task;
+  while (true) {
+    if (TryTake(index, task)) {
+      task();
+      task = nullptr;
+      continue;
+    }
+    std::unique_lock lock(mutex_);
+    ++waiting_;
+    has_work_.wait(lock, [this] { return is_stopping_ || available_ > 0; });
+    --waiting_;
+    if (is_stopping_ && available_ == 0) {
+      return;
+    }
+  }
+}
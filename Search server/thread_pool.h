@@ -0,0 +1,55 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of workers, each with its own task deque. Tasks are spread over
+// the deques round-robin; an idle worker takes from the front of its own
+// deque and steals from the back of the others, and sleeps when all of
+// them are empty. At most queue_capacity tasks may wait at once.
+class ThreadPool {
+ public:
+  ThreadPool(size_t thread_count, size_t queue_capacity);
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  // Runs the tasks that are already queued, then joins the workers.
+  ~ThreadPool();
+
+  // Returns false without queueing the task if the queue is full.
+  bool TrySubmit(std::function<void()> task);
+
+  size_t GetThreadCount() const { return threads_.size(); }
+
+ private:
+  struct WorkerQueue {
+    std::mutex mutex;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  std::vector<std::unique_ptr<WorkerQueue>> queues_;
+  std::vector<std::thread> threads_;
+  const size_t queue_capacity_;
+  // Submitted tasks that no worker has taken yet.
+  std::atomic<size_t> queued_ = 0;
+  // Tasks in the deques. Changes only under the lock of a deque, so it is
+  // never positive while all of them are empty.
+  std::atomic<size_t> available_ = 0;
+  std::atomic<size_t> next_queue_ = 0;
+  std::atomic<bool> is_stopping_ = false;
+  // Workers with nothing to do wait on has_work_ under mutex_, which
+  // submitters take only when some worker is waiting.
+  std::mutex mutex_;
+  std::condition_variable has_work_;
+  std::atomic<size_t> waiting_ = 0;
+
+  bool TryTake(size_t index, std::function<void()>& task);
+
+  void Work(size_t index);
+};
@@ -0,0 +1,199 @@
+#include "tokenizer.h"
+
+#include <cstring>
+
+namespace {
+
+constexpr uint64_t ONES = 0x0101010101010101;
+constexpr uint64_t HIGH_BITS = 0x8080808080808080;
+
+// High bit of each byte of chunk that is at least c; bytes must be ASCII.
+uint64_t BytesAtLeast(uint64_t chunk, uint8_t c) {
+  return ((chunk | HIGH_BITS) - ONES * c) & HIGH_BITS;
+}
+
+uint64_t BytesInRange(uint64_t chunk, uint8_t first, uint8_t last) {
+  return BytesAtLeast(chunk, first) & ~BytesAtLeast(chunk, last + 1);
+}
+
+bool IsAsciiWordCharacter(char c) {
+  return (c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z') ||
+         (c >= 'a' && c <= 'z');
+}
+
+bool IsQuerySyntax(char c) { return c == '-' || c == '*' || c == '"'; }
+
+bool IsSeparator(uint32_t code_point) {
+  if (code_point >= 0x80 && code_point <= 0xBF) {
+    return code_point != 0xAA && code_point != 0xB5 && code_point != 0xBA;
+  }
+  return code_point == 0xD7 || code_point == 0xF7 ||
+         (code_point >= 0x2000 && code_point <= 0x206F) ||
+         (code_point >= 0x3000 && code_point <= 0x303F) ||
+         code_point == 0xFEFF;
+}
+
+// Only capitals whose small letter has the same UTF-8 length.
+uint32_t FoldCase(uint32_t code_point) {
+  if ((code_point >= 0xC0 && code_point <= 0xDE && code_point != 0xD7) ||
+      (code_point >= 0x391 && code_point <= 0x3A9 && code_point != 0x3A2) ||
+      (code_point >= 0x410 && code_point <= 0x42F)) {
+    return code_point + 0x20;
+  }
+  if (code_point >= 0x400 && code_point <= 0x40F) {
+    return code_point + 0x50;
+  }
+  return code_point;
+}
+
+// Length of the UTF-8 sequence at text[position], or 0 if it is malformed.
+size_t DecodeUtf8(std::string_view text, size_t position,
+                  uint32_t& code_point) {
+  const auto lead = static_cast<uint8_t>(text[position]);
+  size_t length;
+  if (lead >= 0xC2 && lead <= 0xDF) {
+    length = 2;
+    code_point = lead & 0x1F;
+  } else if (lead >= 0xE0 && lead <= 0xEF) {
+    length = 3;
+    code_point = lead & 0x0F;
+  } else if (lead >= 0xF0 && lead <= 0xF4) {
+    length = 4;
+    code_point = lead & 0x07;
+  } else {
+    return 0;
+  }
+  if (position + length > text.size()) {
+    return 0;
+  }
+  for (size_t i = 1; i < length; ++i) {
+    const auto byte = static_cast<uint8_t>(text[position + i]);
+    if ((byte & 0xC0) != 0x80) {
+      return 0;
+    }
+    code_point = (code_point << 6) | (byte & 0x3F);
+  }
+  return length;
+}
+
+}  // namespace
+
+size_t DecodeCharacter(std::string_view text, size_t position,
+                       uint32_t& code_point) {
+  const auto lead = static_cast<uint8_t>(text[position]);
+  if (lead < 0x80) {
+    code_point = lead;
+    return 1;
+  }
+  const size_t length = DecodeUtf8(text, position, code_point);
+  if (length == 0) {
+    code_point = 0x110000 + lead;
+    return 1;
+  }
+  return length;
+}
+
+std::string Tokenizer::Normalize(std::string_view text) const {
+  std::string result(text.size(), ' ');
+  Normalize(text, result.data());
+  return result;
+}
+
+void Tokenizer::Normalize(std::string_view text, char* output) const {
+  NormalizeText<false>(text, output);
+}
+
+void Tokenizer::NormalizeQuery(std::string_view text, char* output) const {
+  NormalizeText<true>(text, output);
+  if (!split_on_punctuation_) {
+    return;
+  }
+  // Syntax characters that are not in a syntax position are separators.
+  const auto is_boundary = [output, &text](size_t i) {
+    return i >= text.size() || output[i] == ' ' || output[i] == '"';
+  };
+  for (size_t i = 0; i < text.size(); ++i) {
+    if (output[i] == '-') {
+      if ((i > 0 && !is_boundary(i - 1)) || is_boundary(i + 1)) {
+        output[i] = ' ';
+      }
+    } else if (output[i] == '*') {
+      if (i == 0 || is_boundary(i - 1) || output[i - 1] == '-' ||
+          !is_boundary(i + 1)) {
+        output[i] = ' ';
+      }
+    }
+  }
+}
+
+template <bool keep_query_syntax>
+void Tokenizer::NormalizeText(std::string_view text, char* output) const {
+  size_t position = 0;
+  while (position < text.size()) {
+    if (!keep_query_syntax) {
+      for (; position + sizeof(uint64_t) <= text.size();
+           position += sizeof(uint64_t)) {
+        uint64_t chunk;
+        std::memcpy(&chunk, text.data() + position, sizeof(chunk));
+        if (chunk & HIGH_BITS) {
+          break;
+        }
+        chunk = NormalizeAscii(chunk);
+        std::memcpy(output + position, &chunk, sizeof(chunk));
+      }
+      if (position == text.size()) {
+        break;
+      }
+    }
+    position += NormalizeCharacter<keep_query_syntax>(text, position, output);
+  }
+}
+
+template <bool keep_query_syntax>
+size_t Tokenizer::NormalizeCharacter(std::string_view text, size_t position,
+                                     char* output) const {
+  const char c = text[position];
+  if (!(static_cast<uint8_t>(c) & 0x80)) {
+    if (fold_case_ && c >= 'A' && c <= 'Z') {
+      output[position] = static_cast<char>(c + ('a' - 'A'));
+    } else if (split_on_punctuation_ && !IsAsciiWordCharacter(c) &&
+               !(keep_query_syntax && IsQuerySyntax(c))) {
+      output[position] = ' ';
+    } else {
+      output[position] = c;
+    }
+    return 1;
+  }
+  uint32_t code_point;
+  const size_t length = DecodeUtf8(text, position, code_point);
+  if (length == 0) {
+    output[position] = c;
+    return 1;
+  }
+  if (split_on_punctuation_ && IsSeparator(code_point)) {
+    std::memset(output + position, ' ', length);
+    return length;
+  }
+  const uint32_t folded = fold_case_ ? FoldCase(code_point) : code_point;
+  if (folded == code_point) {
+    std::memcpy(output + position, text.data() + position, length);
+  } else {
+    output[position] = static_cast<char>(0xC0 | (folded >> 6));
+    output[position + 1] = static_cast<char>(0x80 | (folded & 0x3F));
+  }
+  return length;
+}
+
+uint64_t Tokenizer::NormalizeAscii(uint64_t chunk) const {
+  const uint64_t upper = BytesInRange(chunk, 'A', 'Z');
+  const uint64_t word = upper | BytesInRange(chunk, 'a', 'z') |
+                        BytesInRange(chunk, '0', '9');
+  if (fold_case_) {
+    chunk += upper >> 2;
+  }
+  if (split_on_punctuation_) {
+    const uint64_t word_bytes = (word >> 7) * 0xFF;
+    chunk = (chunk & word_bytes) | (ONES * ' ' & ~word_bytes);
+  }
+  return chunk;
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <cstdint>
+#include <set>
+#include <string>
+#include <string_view>
+
+#include "string_processing.h"
+
+// Rewrites text so that splitting it on spaces gives its words. Separators
+// become spaces and, with case folding, capital letters become small ones.
+// Every character keeps its UTF-8 length, so a word has the same offsets
+// in the result as in the original text.
+//
+// Word characters are ASCII letters and digits and every non-ASCII
+// character except the Latin-1 symbols, General Punctuation and CJK
+// punctuation blocks. Case folding covers ASCII, Latin-1, Greek and
+// Cyrillic. Runs of ASCII are processed eight bytes at a time.
+class Tokenizer {
+ public:
+  // Splits on spaces only and keeps case, like SplitIntoWords.
+  Tokenizer() = default;
+
+  Tokenizer(bool split_on_punctuation, bool fold_case)
+      : split_on_punctuation_(split_on_punctuation), fold_case_(fold_case) {}
+
+  static Tokenizer Unicode() { return Tokenizer(true, true); }
+
+  bool IsIdentity() const { return !split_on_punctuation_ && !fold_case_; }
+
+  std::string Normalize(std::string_view text) const;
+
+  // Writes text.size() bytes to output.
+  void Normalize(std::string_view text, char* output) const;
+
+  // Like Normalize, but keeps the query syntax: '-' before a word, '*'
+  // after one and '"'.
+  void NormalizeQuery(std::string_view text, char* output) const;
+
+ private:
+  bool split_on_punctuation_ = false;
+  bool fold_case_ = false;
+
+  template <bool keep_query_syntax>
+  void NormalizeText(std::string_view text, char* output) const;
+
+  // Normalizes the character at text[position] and returns its length.
+  template <bool keep_query_syntax>
+  size_t NormalizeCharacter(std::string_view text, size_t position,
+                            char* output) const;
+
+  uint64_t NormalizeAscii(uint64_t chunk) const;
+};
+
+// Decodes the UTF-8 character at text[position] into code_point and
+// returns its length. A malformed byte is a character of its own, decoded
+// to 0x110000 plus its value so that it differs from every code point.
+size_t DecodeCharacter(std::string_view text, size_t position,
+                       uint32_t& code_point);
+
+// Stop words as the tokenizer leaves them, split again where it made
+// separators into spaces.
+template <typename StringContainer>
+std::set<std::string, std::less<>> MakeStopWords(
+    const StringContainer& stop_words, const Tokenizer& tokenizer) {
+  if (tokenizer.IsIdentity()) {
+    return MakeUniqueNonEmptyStrings(stop_words);
+  }
+  std::set<std::string, std::less<>> result;
+  for (const std::string& stop_word : stop_words) {
+    ForEachWord(tokenizer.Normalize(stop_word),
+                [&result](std::string_view word) { result.emplace(word); });
+  }
+  return result;
+}
@@ -3,26 +3,56 @@
 #include <algorithm>
 #include <cassert>
 #include <cstdlib>
+#include <memory>
+#include <new>
+#include <type_traits>
 #include <utility>
 
-template <typename Type>
-class ArrayPtr {
+// Whether Allocator can resize a buffer with
+// reallocate(data, size, new_size), which returns the resized buffer or
+// nullptr if it can't resize this one.
+template <typename Allocator, typename = void>
+struct HasReallocate : std::false_type {};
+
+template <typename Allocator>
+struct HasReallocate<Allocator,
+                     std::void_t<decltype(std::declval<Allocator&>().reallocate(
+                         std::declval<typename Allocator::value_type*>(),
+                         size_t{}, size_t{}))>> : std::true_type {};
+
+// Owns uninitialized storage for size objects of Type, obtained from
+// Allocator. Constructing and destroying the objects is up to the user of
+// the storage. The allocator moves and swaps along with the storage.
+template <typename Type, typename Allocator = std::allocator<Type>>
+class ArrayPtr : private Allocator {
+  using Traits = std::allocator_traits<Allocator>;
+  static_assert(std::is_same_v<typename Traits::value_type, Type>);
+
  public:
   ArrayPtr() = default;
 
-  explicit ArrayPtr(size_t size)
-      : raw_ptr_(size ? new Type[size]{Type{}} : nullptr) {}
+  explicit ArrayPtr(const Allocator& allocator) noexcept
+      : Allocator(allocator) {}
 
-  explicit ArrayPtr(Type* raw_ptr) noexcept : raw_ptr_(raw_ptr) {}
+  explicit ArrayPtr(size_t size, const Allocator& allocator = Allocator())
+      : Allocator(allocator),
+        raw_ptr_(size ? Allocate(size) : nullptr),
+        size_(raw_ptr_ ? size : 0) {}
+
+  // raw_ptr must come from Release of an ArrayPtr of size elements with an
+  // allocator equal to allocator.
+  ArrayPtr(Type* raw_ptr, size_t size,
+           const Allocator& allocator = Allocator()) noexcept
+      : Allocator(allocator), raw_ptr_(raw_ptr), size_(size) {}
 
   ArrayPtr(const ArrayPtr&) = delete;
 
-  ArrayPtr(ArrayPtr&& rhs) : raw_ptr_(std::exchange(rhs.raw_ptr_, nullptr)) {}
+  ArrayPtr(ArrayPtr&& rhs) noexcept
+      : Allocator(static_cast<Allocator&&>(rhs)),
+        raw_ptr_(std::exchange(rhs.raw_ptr_, nullptr)),
+        size_(std::exchange(rhs.size_, 0)) {}
 
-  ~ArrayPtr() {
-    delete[] raw_ptr_;
-    raw_ptr_ = nullptr;
-  }
+  ~ArrayPtr() { Deallocate(); }
 
   ArrayPtr& operator=(const ArrayPtr&) = delete;
 
@@ -34,8 +64,8 @@ class ArrayPtr {
   }
 
   [[nodiscard]] Type* Release() noexcept {
+    size_ = 0;
     return std::exchange(raw_ptr_, nullptr);
-    ;
   }
 
   Type& operator[](size_t index) noexcept { return *(raw_ptr_ + index); }
@@ -47,8 +77,61 @@ class ArrayPtr {
 
   Type* Get() const noexcept { return raw_ptr_; }
 
-  void swap(ArrayPtr& other) noexcept { std::swap(raw_ptr_, other.raw_ptr_); }
+  size_t GetSize() const noexcept { return size_; }
+
+  const Allocator& GetAllocator() const noexcept { return *this; }
+
+  Allocator& GetAllocator() noexcept { return *this; }
+
+  // Resizes non-empty storage through Allocator::reallocate if there is one.
+  // The bytes may move, so the objects in the storage must be trivially
+  // relocatable. Returns false if the storage is left as it is.
+  bool TryReallocate(size_t size) {
+    if constexpr (HasReallocate<Allocator>::value) {
+      if (raw_ptr_ && size) {
+        if (Type* data = Allocator::reallocate(raw_ptr_, size_, size)) {
+          raw_ptr_ = data;
+          size_ = size;
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
+  // Allocators that can't be swapped, like std::pmr::polymorphic_allocator,
+  // must be equal.
+  void swap(ArrayPtr& other) noexcept {
+    SwapAllocators(other);
+    std::swap(raw_ptr_, other.raw_ptr_);
+    std::swap(size_, other.size_);
+  }
+
+  // Exchanges the allocators but not the storage, so they must be equal
+  // unless neither side holds storage.
+  void SwapAllocators(ArrayPtr& other) noexcept {
+    if constexpr (std::is_swappable_v<Allocator>) {
+      using std::swap;
+      swap(static_cast<Allocator&>(*this), static_cast<Allocator&>(other));
+    } else {
+      assert(GetAllocator() == other.GetAllocator());
+    }
+  }
 
  private:
   Type* raw_ptr_ = nullptr;
-};
\ No newline at end of file
+  size_t size_ = 0;
+
+  Type* Allocate(size_t size) {
+    if (size > Traits::max_size(*this)) {
+      throw std::bad_array_new_length();
+    }
+    return Traits::allocate(*this, size);
+  }
+
+  void Deallocate() noexcept {
+    if (raw_ptr_) {
+      Traits::deallocate(*this, raw_ptr_, size_);
+    }
+  }
+};
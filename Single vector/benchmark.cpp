@@ -0,0 +1,303 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "simple_vector.h"
+
+using namespace std;
+
+namespace {
+
+struct AllocationStats {
+  size_t count = 0;
+  size_t bytes = 0;
+};
+
+AllocationStats allocation_stats;
+
+void* CountedAllocate(size_t size, size_t alignment) {
+  ++allocation_stats.count;
+  allocation_stats.bytes += size;
+  void* data = alignment <= __STDCPP_DEFAULT_NEW_ALIGNMENT__
+                   ? malloc(size ? size : 1)
+                   : aligned_alloc(alignment,
+                                   (size + alignment - 1) / alignment *
+                                       alignment);
+  if (!data) {
+    throw bad_alloc();
+  }
+  return data;
+}
+
+}  // namespace
+
+// Every allocation of the program goes through these, so each benchmark
+// can report how often and how much its containers allocate.
+void* operator new(size_t size) {
+  return CountedAllocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void* operator new(size_t size, align_val_t alignment) {
+  return CountedAllocate(size, static_cast<size_t>(alignment));
+}
+
+void operator delete(void* data) noexcept { free(data); }
+
+void operator delete(void* data, size_t) noexcept { free(data); }
+
+void operator delete(void* data, align_val_t) noexcept { free(data); }
+
+void operator delete(void* data, size_t, align_val_t) noexcept { free(data); }
+
+namespace {
+
+template <typename Value>
+void DoNotOptimize(const Value& value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+template <typename Type, typename Value>
+void PushBack(vector<Type>& v, Value&& value) {
+  v.push_back(forward<Value>(value));
+}
+
+template <typename Type, size_t N, typename Value>
+void PushBack(SimpleVector<Type, N>& v, Value&& value) {
+  v.PushBack(forward<Value>(value));
+}
+
+template <typename Type, typename Value>
+void Insert(vector<Type>& v, size_t index, Value&& value) {
+  v.insert(v.begin() + index, forward<Value>(value));
+}
+
+template <typename Type, size_t N, typename Value>
+void Insert(SimpleVector<Type, N>& v, size_t index, Value&& value) {
+  v.Insert(v.begin() + index, forward<Value>(value));
+}
+
+template <typename Type>
+void Erase(vector<Type>& v, size_t index) {
+  v.erase(v.begin() + index);
+}
+
+template <typename Type, size_t N>
+void Erase(SimpleVector<Type, N>& v, size_t index) {
+  v.Erase(v.begin() + index);
+}
+
+template <typename Type>
+void Reserve(vector<Type>& v, size_t capacity) {
+  v.reserve(capacity);
+}
+
+template <typename Type, size_t N>
+void Reserve(SimpleVector<Type, N>& v, size_t capacity) {
+  v.Reserve(capacity);
+}
+
+template <typename Type>
+void Resize(vector<Type>& v, size_t size) {
+  v.resize(size);
+}
+
+template <typename Type, size_t N>
+void Resize(SimpleVector<Type, N>& v, size_t size) {
+  v.Resize(size);
+}
+
+template <typename Type>
+size_t GetSize(const vector<Type>& v) {
+  return v.size();
+}
+
+template <typename Type, size_t N>
+size_t GetSize(const SimpleVector<Type, N>& v) {
+  return v.GetSize();
+}
+
+// Time and bytes are per operation, allocations are in total.
+struct Result {
+  double nanoseconds = 0;
+  size_t allocations = 0;
+  double bytes = 0;
+};
+
+template <typename Function>
+Result Measure(size_t operations, Function function) {
+  const AllocationStats before = allocation_stats;
+  const auto start = chrono::steady_clock::now();
+  function();
+  const chrono::duration<double, nano> elapsed =
+      chrono::steady_clock::now() - start;
+  const double count = static_cast<double>(operations);
+  return {elapsed.count() / count, allocation_stats.count - before.count,
+          (allocation_stats.bytes - before.bytes) / count};
+}
+
+void PrintHeader() {
+  printf("%-30s %21s %21s %21s\n", "", "ns/op", "allocations", "bytes/op");
+  printf("%-30s", "");
+  for (int i = 0; i < 3; ++i) {
+    printf(" %10s %10s", "std", "Simple");
+  }
+  printf("\n");
+}
+
+void PrintRow(const char* name, const Result& std_result,
+              const Result& simple_result) {
+  printf("%-30s %10.2f %10.2f %10zu %10zu %10.1f %10.1f\n", name,
+         std_result.nanoseconds, simple_result.nanoseconds,
+         std_result.allocations, simple_result.allocations, std_result.bytes,
+         simple_result.bytes);
+}
+
+// run gets an empty container and returns what it measured on it.
+template <typename Type, typename Vector = SimpleVector<Type>, typename Run>
+void Compare(const char* name, Run run) {
+  const Result std_result = run(vector<Type>());
+  const Result simple_result = run(Vector());
+  PrintRow(name, std_result, simple_result);
+}
+
+template <typename Type, typename MakeValue>
+void ComparePushBack(const char* name, size_t count, MakeValue make_value) {
+  Compare<Type>(name, [&](auto v) {
+    return Measure(count, [&] {
+      for (size_t i = 0; i < count; ++i) {
+        PushBack(v, make_value(i));
+      }
+    });
+  });
+}
+
+// Inserts count elements at position(size) and then erases them from
+// there, so front and middle operations shift every element after them.
+template <typename Type, typename Position, typename MakeValue>
+void CompareInsertErase(const char* name, size_t count, Position position,
+                        MakeValue make_value) {
+  Compare<Type>(name, [&](auto v) {
+    return Measure(count * 2, [&] {
+      for (size_t i = 0; i < count; ++i) {
+        Insert(v, position(GetSize(v)), make_value(i));
+      }
+      while (GetSize(v) > 0) {
+        Erase(v, min(position(GetSize(v)), GetSize(v) - 1));
+      }
+    });
+  });
+}
+
+template <typename Type, typename MakeValue>
+void CompareCopy(const char* name, size_t count, size_t repeats,
+                 MakeValue make_value) {
+  Compare<Type>(name, [&](auto v) {
+    for (size_t i = 0; i < count; ++i) {
+      PushBack(v, make_value(i));
+    }
+    return Measure(count * repeats, [&] {
+      for (size_t i = 0; i < repeats; ++i) {
+        const auto copy = v;
+        DoNotOptimize(copy);
+      }
+    });
+  });
+}
+
+template <typename Type, typename MakeValue>
+void CompareMove(const char* name, size_t count, size_t repeats,
+                 MakeValue make_value) {
+  Compare<Type>(name, [&](auto v) {
+    for (size_t i = 0; i < count; ++i) {
+      PushBack(v, make_value(i));
+    }
+    return Measure(repeats, [&] {
+      for (size_t i = 0; i < repeats; ++i) {
+        auto moved = move(v);
+        DoNotOptimize(moved);
+        v = move(moved);
+      }
+    });
+  });
+}
+
+// Builds many short vectors, which SmallVector keeps off the heap.
+template <size_t N>
+void CompareSmall(const char* name, size_t count, size_t size) {
+  Compare<int, SmallVector<int, N>>(name, [&](auto v) {
+    return Measure(count, [&] {
+      for (size_t i = 0; i < count; ++i) {
+        auto small = v;
+        for (size_t j = 0; j < size; ++j) {
+          PushBack(small, static_cast<int>(j));
+        }
+        DoNotOptimize(small);
+      }
+    });
+  });
+}
+
+}  // namespace
+
+int main() {
+  constexpr size_t PUSH_COUNT = 1 << 22;
+  constexpr size_t SHIFT_COUNT = 1 << 14;
+  constexpr size_t COPY_COUNT = 1 << 20;
+  constexpr size_t COPY_REPEATS = 20;
+  constexpr size_t MOVE_REPEATS = 1 << 20;
+  constexpr size_t SMALL_COUNT = 1 << 20;
+  const auto make_int = [](size_t i) { return static_cast<int>(i); };
+  const auto make_unique_int = [](size_t i) {
+    return make_unique<int>(static_cast<int>(i));
+  };
+  const auto make_string = [](size_t i) { return to_string(i); };
+  const auto front = [](size_t) { return size_t{0}; };
+  const auto middle = [](size_t size) { return size / 2; };
+  const auto back = [](size_t size) { return size; };
+
+  PrintHeader();
+  ComparePushBack<int>("PushBack int", PUSH_COUNT, make_int);
+  ComparePushBack<string>("PushBack string", PUSH_COUNT, make_string);
+  ComparePushBack<unique_ptr<int>>("PushBack unique_ptr", PUSH_COUNT,
+                                   make_unique_int);
+  Compare<int>("Reserve + PushBack int", [&](auto v) {
+    return Measure(PUSH_COUNT, [&] {
+      Reserve(v, PUSH_COUNT);
+      for (size_t i = 0; i < PUSH_COUNT; ++i) {
+        PushBack(v, make_int(i));
+      }
+    });
+  });
+  Compare<int>("Resize int", [&](auto v) {
+    return Measure(PUSH_COUNT, [&] {
+      for (size_t size = 1; size <= PUSH_COUNT; size *= 2) {
+        Resize(v, size);
+      }
+    });
+  });
+  CompareInsertErase<int>("Insert/Erase front int", SHIFT_COUNT, front,
+                          make_int);
+  CompareInsertErase<int>("Insert/Erase middle int", SHIFT_COUNT, middle,
+                          make_int);
+  CompareInsertErase<int>("Insert/Erase back int", SHIFT_COUNT, back,
+                          make_int);
+  CompareInsertErase<string>("Insert/Erase front string", SHIFT_COUNT, front,
+                             make_string);
+  CompareInsertErase<string>("Insert/Erase middle string", SHIFT_COUNT,
+                             middle, make_string);
+  CompareInsertErase<string>("Insert/Erase back string", SHIFT_COUNT, back,
+                             make_string);
+  CompareInsertErase<unique_ptr<int>>("Insert/Erase front unique_ptr",
+                                      SHIFT_COUNT, front, make_unique_int);
+  CompareCopy<int>("Copy int", COPY_COUNT, COPY_REPEATS, make_int);
+  CompareCopy<string>("Copy string", COPY_COUNT, COPY_REPEATS,
+                      make_string);
+  CompareMove<string>("Move string vector", COPY_COUNT, MOVE_REPEATS,
+                      make_string);
+  CompareSmall<4>("3 ints, SmallVector<int, 4>", SMALL_COUNT, 3);
+}
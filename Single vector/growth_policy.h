@@ -0,0 +1,43 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+
+// Growth policies give the capacity a SimpleVector grows to when it needs
+// room for required elements of element_size bytes; the result is at least
+// required.
+
+struct DoublingGrowth {
+  static size_t GetNewCapacity(size_t capacity, size_t required,
+                               size_t /*element_size*/) noexcept {
+    return std::max(required, capacity == 0 ? 1 : capacity * 2);
+  }
+};
+
+// Grows slower than DoublingGrowth, so less memory sits unused, at the
+// price of more reallocations.
+struct OneAndHalfGrowth {
+  static size_t GetNewCapacity(size_t capacity, size_t required,
+                               size_t /*element_size*/) noexcept {
+    return std::max(required, capacity + capacity / 2);
+  }
+};
+
+// Rounds buffers of at least MIN_BYTES up to whole pages. glibc malloc
+// serves such buffers with their own mappings, so the rounded up part is
+// allocated anyway.
+template <typename BaseGrowth = DoublingGrowth, size_t PAGE_SIZE = 4096,
+          size_t MIN_BYTES = 128 * 1024>
+struct PageRoundedGrowth {
+  static size_t GetNewCapacity(size_t capacity, size_t required,
+                               size_t element_size) noexcept {
+    const size_t new_capacity =
+        BaseGrowth::GetNewCapacity(capacity, required, element_size);
+    const size_t bytes = new_capacity * element_size;
+    if (bytes < MIN_BYTES) {
+      return new_capacity;
+    }
+    const size_t pages = (bytes + PAGE_SIZE - 1) / PAGE_SIZE;
+    return pages * PAGE_SIZE / element_size;
+  }
+};
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <sys/mman.h>
+
+#include <cstddef>
+#include <memory>
+#include <new>
+
+// Allocator that maps buffers of at least MIN_BYTES straight from the
+// kernel and asks for transparent huge pages for them, so that scanning
+// them takes fewer TLB misses. Such buffers can also be resized with
+// reallocate, which remaps their pages instead of copying the bytes.
+// Smaller buffers come from std::allocator.
+template <typename Type, size_t MIN_BYTES = 32 << 20>
+class HugePageAllocator {
+ public:
+  using value_type = Type;
+
+  template <typename Other>
+  struct rebind {
+    using other = HugePageAllocator<Other, MIN_BYTES>;
+  };
+
+  HugePageAllocator() = default;
+
+  template <typename Other>
+  HugePageAllocator(const HugePageAllocator<Other, MIN_BYTES>&) noexcept {}
+
+  Type* allocate(size_t size) {
+    if (!IsMapped(size)) {
+      return std::allocator<Type>().allocate(size);
+    }
+    void* data = mmap(nullptr, GetMappedBytes(size), PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (data == MAP_FAILED) {
+      throw std::bad_alloc();
+    }
+    AdviseHugePages(data, GetMappedBytes(size));
+    return static_cast<Type*>(data);
+  }
+
+  void deallocate(Type* data, size_t size) noexcept {
+    if (!IsMapped(size)) {
+      std::allocator<Type>().deallocate(data, size);
+    } else {
+      munmap(data, GetMappedBytes(size));
+    }
+  }
+
+  // Resizes a buffer of size objects to new_size, possibly moving its
+  // bytes to another address, which is returned. Returns nullptr and
+  // leaves the buffer alone if either size is below MIN_BYTES.
+  Type* reallocate(Type* data, size_t size, size_t new_size) {
+    if (!IsMapped(size) || !IsMapped(new_size)) {
+      return nullptr;
+    }
+    void* new_data = mremap(data, GetMappedBytes(size),
+                            GetMappedBytes(new_size), MREMAP_MAYMOVE);
+    if (new_data == MAP_FAILED) {
+      throw std::bad_alloc();
+    }
+    AdviseHugePages(new_data, GetMappedBytes(new_size));
+    return static_cast<Type*>(new_data);
+  }
+
+  template <typename Other>
+  bool operator==(const HugePageAllocator<Other, MIN_BYTES>&) const noexcept {
+    return true;
+  }
+
+  template <typename Other>
+  bool operator!=(const HugePageAllocator<Other, MIN_BYTES>&) const noexcept {
+    return false;
+  }
+
+ private:
+  static constexpr size_t PAGE_SIZE = 4096;
+
+  static bool IsMapped(size_t size) noexcept {
+    return size >= (MIN_BYTES + sizeof(Type) - 1) / sizeof(Type);
+  }
+
+  static size_t GetMappedBytes(size_t size) noexcept {
+    return (size * sizeof(Type) + PAGE_SIZE - 1) / PAGE_SIZE * PAGE_SIZE;
+  }
+
+  static void AdviseHugePages([[maybe_unused]] void* data,
+                              [[maybe_unused]] size_t bytes) noexcept {
+#ifdef MADV_HUGEPAGE
+    madvise(data, bytes, MADV_HUGEPAGE);
+#endif
+  }
+};
@@ -1,8 +1,18 @@
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <climits>
 #include <iostream>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
 #include <numeric>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
 
+#include "huge_page_allocator.h"
 #include "simple_vector.h"
 
 using namespace std;
@@ -24,6 +34,163 @@ class X {
   size_t x_;
 };
 
+class Counted {
+ public:
+  inline static int constructed = 0;
+  inline static int destroyed = 0;
+
+  explicit Counted(int value) : value_(value) { ++constructed; }
+  Counted(const Counted& other) : value_(other.value_) { ++constructed; }
+  Counted(Counted&& other) : value_(exchange(other.value_, 0)) {
+    ++constructed;
+  }
+  Counted& operator=(const Counted&) = default;
+  Counted& operator=(Counted&&) = default;
+  ~Counted() { ++destroyed; }
+
+  int GetValue() const { return value_; }
+
+  static int GetAlive() { return constructed - destroyed; }
+
+ private:
+  int value_;
+};
+
+// Move may throw, so reallocation has to copy it. Copying throws once
+// copies_left runs out.
+class MayThrowOnMove {
+ public:
+  inline static int copies = 0;
+  inline static int copies_left = INT_MAX;
+
+  MayThrowOnMove(string name, int value) : name_(move(name)), value_(value) {}
+  MayThrowOnMove(const MayThrowOnMove& other)
+      : name_(other.name_), value_(other.value_) {
+    if (copies_left-- == 0) {
+      throw runtime_error("copy failed"s);
+    }
+    ++copies;
+  }
+  MayThrowOnMove(MayThrowOnMove&& other) noexcept(false)
+      : name_(move(other.name_)), value_(other.value_) {}
+  MayThrowOnMove& operator=(const MayThrowOnMove&) = default;
+  MayThrowOnMove& operator=(MayThrowOnMove&&) = default;
+
+  const string& GetName() const { return name_; }
+  int GetValue() const { return value_; }
+
+ private:
+  string name_;
+  int value_;
+};
+
+// Counts moves, which relocation by bytes must not make.
+class Relocated {
+ public:
+  inline static int moves = 0;
+
+  explicit Relocated(int value) : value_(make_unique<int>(value)) {}
+  Relocated(Relocated&& other) noexcept : value_(move(other.value_)) {
+    ++moves;
+  }
+  Relocated& operator=(Relocated&& other) noexcept {
+    value_ = move(other.value_);
+    ++moves;
+    return *this;
+  }
+
+  int GetValue() const { return *value_; }
+
+ private:
+  unique_ptr<int> value_;
+};
+
+template <>
+struct IsTriviallyRelocatable<Relocated> : true_type {};
+
+// Counts the bytes it has handed out and not yet got back.
+class CountingResource : public pmr::memory_resource {
+ public:
+  size_t GetBytesInUse() const { return bytes_in_use_; }
+
+ private:
+  size_t bytes_in_use_ = 0;
+
+  void* do_allocate(size_t bytes, size_t alignment) override {
+    bytes_in_use_ += bytes;
+    return pmr::new_delete_resource()->allocate(bytes, alignment);
+  }
+
+  void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+    bytes_in_use_ -= bytes;
+    pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+  }
+
+  bool do_is_equal(const memory_resource& other) const noexcept override {
+    return this == &other;
+  }
+};
+
+// Allocators with any tags are equal, so the tag only tells which vector an
+// allocator came from.
+template <typename Type, bool PROPAGATE_ON_SWAP>
+class TaggedAllocator {
+ public:
+  using value_type = Type;
+  using propagate_on_container_swap = bool_constant<PROPAGATE_ON_SWAP>;
+
+  template <typename Other>
+  struct rebind {
+    using other = TaggedAllocator<Other, PROPAGATE_ON_SWAP>;
+  };
+
+  explicit TaggedAllocator(int tag = 0) : tag_(tag) {}
+
+  template <typename Other>
+  TaggedAllocator(const TaggedAllocator<Other, PROPAGATE_ON_SWAP>& other)
+      : tag_(other.GetTag()) {}
+
+  int GetTag() const { return tag_; }
+
+  Type* allocate(size_t size) { return allocator<Type>().allocate(size); }
+
+  void deallocate(Type* data, size_t size) {
+    allocator<Type>().deallocate(data, size);
+  }
+
+  template <typename Other>
+  bool operator==(const TaggedAllocator<Other, PROPAGATE_ON_SWAP>&) const {
+    return true;
+  }
+
+  template <typename Other>
+  bool operator!=(const TaggedAllocator<Other, PROPAGATE_ON_SWAP>&) const {
+    return false;
+  }
+
+ private:
+  int tag_;
+};
+
+// Default construction throws once throw_at objects have been built.
+class ThrowingDefault {
+ public:
+  inline static atomic<int> alive = 0;
+  inline static atomic<int> throw_at = INT_MAX;
+
+  ThrowingDefault() {
+    if (throw_at-- == 0) {
+      throw runtime_error("construction failed"s);
+    }
+    ++alive;
+  }
+  ThrowingDefault(const ThrowingDefault&) { ++alive; }
+  ~ThrowingDefault() { --alive; }
+
+ private:
+  int value_ = 0;
+};
+
 SimpleVector<int> GenerateVector(size_t size) {
   SimpleVector<int> v(size);
   iota(v.begin(), v.end(), 1);
@@ -397,6 +564,467 @@ void TestReserveMethod() {
   cout << "OK!"s << endl;
 }
 
+void TestUninitializedStorage() {
+  cout << "TestUninitializedStorage: \t"s;
+  {
+    SimpleVector<Counted> v(Reserve(100));
+    assert(Counted::GetAlive() == 0);
+    for (int i = 0; i < 10; ++i) {
+      v.PushBack(Counted(i));
+    }
+    assert(Counted::GetAlive() == 10);
+    v.Reserve(1000);
+    assert(Counted::GetAlive() == 10);
+    v.Insert(v.begin() + 5, Counted(42));
+    assert(Counted::GetAlive() == 11);
+    assert(v[5].GetValue() == 42 && v[6].GetValue() == 5);
+    v.Erase(v.begin());
+    v.PopBack();
+    assert(Counted::GetAlive() == 9);
+    v.PushBack(v[0]);
+    assert(v[9].GetValue() == v[0].GetValue());
+    while (v.GetSize() > 3) {
+      v.PopBack();
+    }
+    assert(Counted::GetAlive() == 3);
+    SimpleVector<Counted> copy(v);
+    assert(Counted::GetAlive() == 6);
+    copy.Clear();
+    assert(Counted::GetAlive() == 3);
+  }
+  assert(Counted::GetAlive() == 0);
+  cout << "OK!"s << endl;
+}
+
+void TestEmplace() {
+  cout << "TestEmplace: \t\t\t"s;
+  {
+    SimpleVector<MayThrowOnMove> v;
+    v.EmplaceBack("b"s, 2);
+    MayThrowOnMove& back = v.EmplaceBack("c"s, 3);
+    assert(&back == &v[1]);
+    auto it = v.Emplace(v.begin(), "a"s, 1);
+    assert(it == v.begin() && it->GetName() == "a"s);
+    v.Emplace(v.end(), "d"s, 4);
+    for (int i = 0; i < 4; ++i) {
+      assert(v[i].GetValue() == i + 1);
+    }
+  }
+  {
+    SimpleVector<MayThrowOnMove> v;
+    v.Reserve(3);
+    v.EmplaceBack("a"s, 1);
+    v.EmplaceBack("b"s, 2);
+    v.EmplaceBack("c"s, 3);
+    MayThrowOnMove::copies = 0;
+    MayThrowOnMove::copies_left = 1;
+    try {
+      v.EmplaceBack("d"s, 4);
+      assert(false);
+    } catch (const runtime_error&) {
+    }
+    MayThrowOnMove::copies_left = INT_MAX;
+    assert(MayThrowOnMove::copies == 1);
+    assert(v.GetSize() == 3 && v.GetCapacity() == 3);
+    assert(v[0].GetName() == "a"s && v[2].GetName() == "c"s);
+    v.EmplaceBack("d"s, 4);
+    assert(MayThrowOnMove::copies == 4);
+    assert(v[3].GetName() == "d"s);
+  }
+  {
+    SimpleVector<string> v;
+    v.EmplaceBack(3, 'x');
+    v.EmplaceBack(v[0]);
+    v.Emplace(v.begin(), v[1], 1, 1);
+    assert((v == SimpleVector<string>{"x"s, "xxx"s, "xxx"s}));
+  }
+  cout << "OK!"s << endl;
+}
+
+void TestTriviallyRelocatable() {
+  cout << "TestTriviallyRelocatable: \t"s;
+  {
+    SimpleVector<Relocated> v;
+    for (int i = 1; i <= 100; ++i) {
+      v.EmplaceBack(i);
+    }
+    v.Emplace(v.begin(), 0);
+    v.Emplace(v.begin() + 50, -1);
+    v.Reserve(1000);
+    v.Emplace(v.begin(), -2);
+    v.Erase(v.begin() + 1);
+    v.Erase(v.end() - 1);
+    assert(Relocated::moves == 0);
+    assert(v.GetSize() == 101);
+    assert(v[0].GetValue() == -2 && v[1].GetValue() == 1);
+    assert(v[50].GetValue() == -1 && v[100].GetValue() == 99);
+  }
+  {
+    SimpleVector<unique_ptr<int>> v;
+    for (int i = 0; i < 10; ++i) {
+      v.Insert(v.begin(), make_unique<int>(i));
+    }
+    v.Erase(v.begin() + 5);
+    v.PushBack(make_unique<int>(10));
+    v.Insert(v.begin() + 3, make_unique<int>(11));
+    const int expected[] = {9, 8, 7, 11, 6, 5, 3, 2, 1, 0, 10};
+    assert(v.GetSize() == size(expected));
+    for (size_t i = 0; i < v.GetSize(); ++i) {
+      assert(*v[i] == expected[i]);
+    }
+  }
+  {
+    SimpleVector<int> v = {1, 2, 3};
+    v.Insert(v.begin() + 1, v[2]);
+    v.Insert(v.begin(), v[3]);
+    v.Erase(v.begin() + 2);
+    assert((v == SimpleVector<int>{3, 1, 2, 3}));
+  }
+  cout << "OK!"s << endl;
+}
+
+template <typename Type, size_t N>
+bool IsInline(const SmallVector<Type, N>& v) {
+  const auto* object = reinterpret_cast<const char*>(&v);
+  const auto* data = reinterpret_cast<const char*>(v.begin());
+  return data >= object && data < object + sizeof(v);
+}
+
+void TestSmallVector() {
+  cout << "TestSmallVector: \t\t"s;
+  static_assert(sizeof(SimpleVector<int>) == sizeof(SimpleVector<char>));
+  {
+    SmallVector<int, 4> v;
+    assert(v.GetCapacity() == 4 && IsInline(v));
+    for (int i = 1; i <= 4; ++i) {
+      v.PushBack(i);
+    }
+    assert(IsInline(v));
+    v.Insert(v.begin(), 0);
+    assert(!IsInline(v) && v.GetCapacity() == 8);
+    assert((v == SmallVector<int, 4>{0, 1, 2, 3, 4}));
+    SmallVector<int, 4> copy = {5, 6};
+    assert(IsInline(copy));
+    copy = v;
+    assert(copy == v && !IsInline(copy));
+  }
+  {
+    SmallVector<Counted, 2> small;
+    small.EmplaceBack(1);
+    SmallVector<Counted, 2> large;
+    for (int i = 2; i <= 4; ++i) {
+      large.EmplaceBack(i);
+    }
+    small.swap(large);
+    assert(small.GetSize() == 3 && small[0].GetValue() == 2);
+    assert(large.GetSize() == 1 && large[0].GetValue() == 1);
+    assert(IsInline(large) && !IsInline(small));
+    const auto* heap = small.begin();
+    SmallVector<Counted, 2> moved(move(small));
+    assert(moved.begin() == heap && small.GetSize() == 0);
+    assert(IsInline(small) && small.GetCapacity() == 2);
+    small = move(large);
+    assert(IsInline(small) && small[0].GetValue() == 1);
+    assert(large.GetSize() == 0);
+    moved = move(small);
+    assert(IsInline(moved) && moved.GetSize() == 1);
+    assert(Counted::GetAlive() == 1);
+    // Heap storage is taken over, and the elements it replaces destroyed.
+    for (int i = 0; i < 3; ++i) {
+      large.EmplaceBack(i);
+    }
+    heap = large.begin();
+    moved = move(large);
+    assert(moved.begin() == heap && moved.GetSize() == 3);
+    assert(IsInline(large) && large.GetSize() == 0);
+    for (int i = 0; i < 4; ++i) {
+      large.EmplaceBack(i);
+    }
+    heap = large.begin();
+    moved = move(large);
+    assert(moved.begin() == heap && moved[3].GetValue() == 3);
+    assert(Counted::GetAlive() == 4);
+  }
+  assert(Counted::GetAlive() == 0);
+  {
+    SmallVector<unique_ptr<int>, 3> v;
+    v.PushBack(make_unique<int>(1));
+    v.PushBack(make_unique<int>(2));
+    SmallVector<unique_ptr<int>, 3> other(move(v));
+    assert(*other[1] == 2 && v.IsEmpty());
+    other.Erase(other.begin());
+    assert(*other[0] == 2);
+  }
+  cout << "OK!"s << endl;
+}
+
+template <bool PROPAGATE_ON_SWAP>
+void CheckSwap(int lhs_size, int rhs_size) {
+  using Allocator = TaggedAllocator<int, PROPAGATE_ON_SWAP>;
+  SimpleVector<int, 2, Allocator> lhs(lhs_size, 1, Allocator(1));
+  SimpleVector<int, 2, Allocator> rhs(rhs_size, 2, Allocator(2));
+  lhs.swap(rhs);
+  assert(lhs.GetSize() == static_cast<size_t>(rhs_size) && lhs[0] == 2);
+  assert(rhs.GetSize() == static_cast<size_t>(lhs_size) && rhs[0] == 1);
+  assert(lhs.GetAllocator().GetTag() == (PROPAGATE_ON_SWAP ? 2 : 1));
+  assert(rhs.GetAllocator().GetTag() == (PROPAGATE_ON_SWAP ? 1 : 2));
+}
+
+void TestAllocator() {
+  cout << "TestAllocator: \t\t\t"s;
+  CountingResource first;
+  CountingResource second;
+  {
+    PmrSimpleVector<int> v(&first);
+    for (int i = 0; i < 10; ++i) {
+      v.PushBack(i);
+    }
+    assert(first.GetBytesInUse() == 16 * sizeof(int));
+    PmrSimpleVector<int> moved(move(v));
+    assert(moved.GetAllocator().resource() == &first);
+    assert(first.GetBytesInUse() == 16 * sizeof(int));
+
+    PmrSimpleVector<int> other({1, 2, 3}, &second);
+    other = moved;
+    assert(other == moved && other.GetAllocator().resource() == &second);
+    assert(second.GetBytesInUse() == 10 * sizeof(int));
+    other = move(moved);
+    assert(other.GetAllocator().resource() == &second);
+    assert(second.GetBytesInUse() == 10 * sizeof(int));
+
+    PmrSimpleVector<int> copy(other);
+    assert(copy.GetAllocator().resource() == pmr::get_default_resource());
+
+    PmrSimpleVector<int> same({1, 2, 3, 4}, &second);
+    const int* data = other.begin();
+    same = move(other);
+    assert(same.begin() == data && other.IsEmpty());
+    assert(second.GetBytesInUse() == 10 * sizeof(int));
+  }
+  assert(first.GetBytesInUse() == 0 && second.GetBytesInUse() == 0);
+  {
+    PmrSimpleVector<string, 2> small(&first);
+    small.EmplaceBack("a"s);
+    assert(first.GetBytesInUse() == 0);
+    small.EmplaceBack("b"s);
+    small.EmplaceBack("c"s);
+    assert(first.GetBytesInUse() == 4 * sizeof(string));
+    PmrSimpleVector<string, 2> other(&first);
+    other.EmplaceBack("d"s);
+    other.swap(small);
+    assert(other.GetSize() == 3 && small.GetSize() == 1);
+    assert(small[0] == "d"s && other[2] == "c"s);
+  }
+  assert(first.GetBytesInUse() == 0);
+  {
+    // Elements are built through the allocator, which passes its resource
+    // on to them, inline or not.
+    const pmr::string text(40, 'x');
+    const auto uses = [](const auto& v, pmr::memory_resource* resource) {
+      return all_of(v.begin(), v.end(), [resource](const pmr::string& s) {
+        return s.get_allocator().resource() == resource;
+      });
+    };
+    PmrSimpleVector<pmr::string, 2> v(&first);
+    v.EmplaceBack(text);
+    v.PushBack(text);
+    assert(uses(v, &first));
+    v.EmplaceBack(text);
+    v.Insert(v.begin(), text);
+    v.Emplace(v.begin() + 1, 40, 'y');
+    v.Resize(7);
+    assert(v.GetSize() == 7 && v[1] == pmr::string(40, 'y'));
+    assert(uses(v, &first));
+    PmrSimpleVector<pmr::string, 2> copy(v, &second);
+    assert(copy == v && uses(copy, &second));
+    PmrSimpleVector<pmr::string, 2> filled(3, text, &second);
+    assert(uses(filled, &second));
+    filled = move(v);
+    assert(filled.GetSize() == 7 && uses(filled, &second));
+  }
+  assert(first.GetBytesInUse() == 0 && second.GetBytesInUse() == 0);
+  {
+    // Allocators go along with the elements only if they propagate on swap,
+    // whether the elements are inline or not.
+    CheckSwap<true>(1, 2);
+    CheckSwap<true>(1, 3);
+    CheckSwap<true>(3, 4);
+    CheckSwap<false>(1, 2);
+    CheckSwap<false>(1, 3);
+    CheckSwap<false>(3, 4);
+  }
+  cout << "OK!"s << endl;
+}
+
+void TestGrowthPolicy() {
+  cout << "TestGrowthPolicy: \t\t"s;
+  {
+    SimpleVector<int, 0, allocator<int>, OneAndHalfGrowth> v;
+    size_t capacities[6];
+    for (size_t& capacity : capacities) {
+      v.PushBack(0);
+      capacity = v.GetCapacity();
+    }
+    const size_t expected[] = {1, 2, 3, 4, 6, 6};
+    assert(equal(begin(capacities), end(capacities), begin(expected)));
+  }
+  {
+    using Growth = PageRoundedGrowth<DoublingGrowth, 4096, 8192>;
+    assert(Growth::GetNewCapacity(100, 101, 12) == 200);
+    assert(Growth::GetNewCapacity(1000, 1001, 12) == 4096 * 6 / 12);
+    SimpleVector<char, 0, allocator<char>, Growth> v(5000);
+    v.PushBack('a');
+    assert(v.GetCapacity() == 12288);
+  }
+  cout << "OK!"s << endl;
+}
+
+void TestShrinkToFit() {
+  cout << "TestShrinkToFit: \t\t"s;
+  {
+    SimpleVector<int> v = GenerateVector(10);
+    v.Reserve(100);
+    v.ShrinkToFit();
+    assert(v.GetCapacity() == 10 && v == GenerateVector(10));
+    v.Clear();
+    v.ShrinkToFit();
+    assert(v.GetCapacity() == 0 && v.begin() == nullptr);
+  }
+  {
+    SmallVector<Counted, 4> v;
+    for (int i = 0; i < 6; ++i) {
+      v.EmplaceBack(i);
+    }
+    v.PopBack();
+    v.PopBack();
+    v.ShrinkToFit();
+    assert(IsInline(v) && v.GetCapacity() == 4);
+    assert(v[3].GetValue() == 3 && Counted::GetAlive() == 4);
+  }
+  assert(Counted::GetAlive() == 0);
+  cout << "OK!"s << endl;
+}
+
+void TestAppend() {
+  cout << "TestAppend: \t\t\t"s;
+  {
+    SimpleVector<int> v = {1, 2};
+    const int values[] = {3, 4, 5};
+    v.Append(begin(values), end(values));
+    assert((v == SimpleVector<int>{1, 2, 3, 4, 5}));
+    assert(v.GetCapacity() == 5);
+    v.Append(v.begin(), v.end());
+    assert((v == SimpleVector<int>{1, 2, 3, 4, 5, 1, 2, 3, 4, 5}));
+  }
+  {
+    SimpleVector<string> v = {"a"s};
+    v.Reserve(4);
+    v.Append(v.begin(), v.end());
+    istringstream input("b c"s);
+    v.Append(istream_iterator<string>(input), istream_iterator<string>());
+    assert((v == SimpleVector<string>{"a"s, "a"s, "b"s, "c"s}));
+    assert(v.GetCapacity() == 4);
+  }
+  cout << "OK!"s << endl;
+}
+
+void TestHugePageAllocator() {
+  cout << "TestHugePageAllocator: \t\t"s;
+  using Allocator = HugePageAllocator<int, 1 << 16>;
+  {
+    SimpleVector<int, 0, Allocator> v;
+    for (int i = 0; i < 100000; ++i) {
+      v.PushBack(i);
+    }
+    v.Insert(v.begin(), v[99999]);
+    v.Resize(300000);
+    assert(v.GetSize() == 300000 && v[0] == 99999 && v[1] == 0);
+    assert(v[100000] == 99999 && v[100001] == 0 && v[299999] == 0);
+    v.Resize(20000);
+    v.ShrinkToFit();
+    assert(v.GetCapacity() == 20000 && v[19999] == 19998);
+    v.Resize(10);
+    v.ShrinkToFit();
+    assert(v.GetCapacity() == 10 && v[9] == 8);
+  }
+  {
+    SimpleVector<string, 0, HugePageAllocator<string, 1 << 16>> v;
+    for (int i = 0; i < 10000; ++i) {
+      v.PushBack(to_string(i));
+    }
+    assert(v[9999] == "9999"s);
+  }
+  cout << "OK!"s << endl;
+}
+
+void TestBitwiseComparison() {
+  cout << "TestBitwiseComparison: \t\t"s;
+  {
+    SimpleVector<int> lhs = GenerateVector(1000);
+    SimpleVector<int> rhs = lhs;
+    assert(lhs == rhs && !(lhs < rhs) && !(rhs < lhs));
+    rhs[700] = -1;
+    assert(lhs != rhs && rhs < lhs && !(lhs < rhs));
+    rhs[700] = lhs[700];
+    rhs.PopBack();
+    assert(lhs != rhs && rhs < lhs);
+    assert((SimpleVector<int>{-1} < SimpleVector<int>{1}));
+    assert((SimpleVector<int>{256} > SimpleVector<int>{1}));
+    assert(SimpleVector<int>() == SimpleVector<int>());
+    assert(SimpleVector<int>() < SimpleVector<int>{0});
+  }
+  {
+    enum class Color { RED, GREEN };
+    SimpleVector<Color> lhs(300, Color::RED);
+    SimpleVector<Color> rhs = lhs;
+    rhs[299] = Color::GREEN;
+    assert(lhs < rhs && lhs != rhs);
+  }
+  {
+    SimpleVector<double> lhs = {0.0, 1.0};
+    SimpleVector<double> rhs = {-0.0, 1.0};
+    assert(lhs == rhs && !(lhs < rhs) && !(rhs < lhs));
+  }
+  cout << "OK!"s << endl;
+}
+
+void TestParallel() {
+  cout << "TestParallel: \t\t\t"s;
+  const size_t size = 3'000'000;
+  {
+    SimpleVector<int> v(size, Parallel(4));
+    assert(v.GetSize() == size);
+    assert(all_of(v.begin(), v.end(), [](int x) { return x == 0; }));
+    v.Transform([](int x) { return x + 2; }, Parallel(4));
+    assert(all_of(v.begin(), v.end(), [](int x) { return x == 2; }));
+    v.Resize(size * 2, Parallel(4));
+    assert(v[size - 1] == 2 && v[size] == 0 && v[size * 2 - 1] == 0);
+    SimpleVector<int> filled(size, 7, Parallel(3));
+    assert(all_of(filled.begin(), filled.end(), [](int x) { return x == 7; }));
+  }
+  {
+    ThrowingDefault::throw_at = 2'000'000;
+    try {
+      SimpleVector<ThrowingDefault> v(size, Parallel(4));
+      assert(false);
+    } catch (const runtime_error&) {
+    }
+    ThrowingDefault::throw_at = INT_MAX;
+    assert(ThrowingDefault::alive == 0);
+  }
+  {
+    SimpleVector<int> v(10, 1);
+    try {
+      v.Transform([](int) -> int { throw runtime_error("failed"s); },
+                  Parallel(4));
+      assert(false);
+    } catch (const runtime_error&) {
+    }
+    assert(v.GetSize() == 10);
+  }
+  cout << "OK!"s << endl;
+}
+
 void AllTests() {
   TestDefaultConstructor();
   cout << "Test1: \t\t\t\t"s;
@@ -416,6 +1044,17 @@ void AllTests() {
   TestNoncopiableErase();
   TestResize();
   TestDeleteObj();
+  TestUninitializedStorage();
+  TestEmplace();
+  TestTriviallyRelocatable();
+  TestSmallVector();
+  TestAllocator();
+  TestGrowthPolicy();
+  TestShrinkToFit();
+  TestAppend();
+  TestHugePageAllocator();
+  TestBitwiseComparison();
+  TestParallel();
 }
 
 int main() {
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+// Part [begin, end) of a range split by RunInChunks, with the exception its
+// function threw, if any.
+struct Chunk {
+  size_t begin = 0;
+  size_t end = 0;
+  std::exception_ptr error;
+};
+
+// Splits [0, size) into at most thread_count contiguous chunks of at least
+// min_chunk_size elements and calls function(begin, end) for each chunk,
+// one chunk per thread. The first chunk runs on the calling thread, and so
+// do the others if no thread can be started for them.
+template <typename Function>
+std::vector<Chunk> RunInChunks(size_t size, size_t thread_count,
+                               size_t min_chunk_size, Function function) {
+  const size_t chunk_count =
+      std::clamp<size_t>(size / std::max<size_t>(min_chunk_size, 1), 1,
+                         std::max<size_t>(thread_count, 1));
+  const size_t chunk_size = size / chunk_count;
+  const size_t remainder = size % chunk_count;
+  std::vector<Chunk> chunks(chunk_count);
+  for (size_t i = 0; i < chunk_count; ++i) {
+    chunks[i].begin = i * chunk_size + std::min(i, remainder);
+    chunks[i].end = chunks[i].begin + chunk_size + (i < remainder ? 1 : 0);
+  }
+  const auto run = [&function](Chunk& chunk) {
+    try {
+      function(chunk.begin, chunk.end);
+    } catch (...) {
+      chunk.error = std::current_exception();
+    }
+  };
+  std::vector<std::thread> threads;
+  threads.reserve(chunk_count - 1);
+  size_t next_chunk = 1;
+  try {
+    for (; next_chunk < chunk_count; ++next_chunk) {
+      threads.emplace_back(run, std::ref(chunks[next_chunk]));
+    }
+  } catch (const std::system_error&) {
+  }
+  for (; next_chunk < chunk_count; ++next_chunk) {
+    run(chunks[next_chunk]);
+  }
+  run(chunks[0]);
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  return chunks;
+}
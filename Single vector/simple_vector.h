@@ -1,10 +1,20 @@
 #pragma once
 
 #include <algorithm>
+#include <cstring>
 #include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <new>
 #include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
 
 #include "array_ptr.h"
+#include "growth_policy.h"
+#include "parallel_chunks.h"
 
 class ReserveProxyObj {
  public:
@@ -23,285 +33,828 @@ ReserveProxyObj Reserve(size_t capacity_to_reserve) {
   return ReserveProxyObj(capacity_to_reserve);
 }
 
+// Asks SimpleVector to split bulk initialization and transforms over
+// threads. Each thread writes its own contiguous part of the buffer, and
+// writes it first, so the kernel places the pages of that part on the NUMA
+// node the thread runs on.
+class ParallelProxyObj {
+ public:
+  explicit ParallelProxyObj(size_t thread_count)
+      : thread_count_(std::max<size_t>(thread_count, 1)) {}
+
+  size_t GetThreadCount() const noexcept { return thread_count_; }
+
+ private:
+  size_t thread_count_;
+};
+
+inline ParallelProxyObj Parallel(
+    size_t thread_count = std::thread::hardware_concurrency()) {
+  return ParallelProxyObj(thread_count);
+}
+
+// Types whose objects can be moved to other storage by copying their bytes,
+// after which the source counts as destroyed. Specialize it for other
+// types that hold no pointers into themselves.
 template <typename Type>
-class SimpleVector {
+struct IsTriviallyRelocatable : std::is_trivially_copyable<Type> {};
+
+template <typename Type, typename Deleter>
+struct IsTriviallyRelocatable<std::unique_ptr<Type, Deleter>>
+    : IsTriviallyRelocatable<Deleter> {};
+
+template <typename Type>
+struct IsTriviallyRelocatable<std::default_delete<Type>> : std::true_type {};
+
+// Whether Allocator has its own construct, which allocator_traits calls
+// instead of placement new, as std::pmr::polymorphic_allocator does to pass
+// itself on to the objects.
+template <typename Allocator, typename = void>
+struct HasConstruct : std::false_type {};
+
+template <typename Allocator>
+struct HasConstruct<Allocator,
+                    std::void_t<decltype(std::declval<Allocator&>().construct(
+                        std::declval<typename Allocator::value_type*>()))>>
+    : std::true_type {};
+
+// Uninitialized room for Capacity elements inside the vector object.
+template <typename Type, size_t Capacity>
+class InlineBuffer {
+ protected:
+  Type* GetInlineData() noexcept { return reinterpret_cast<Type*>(bytes_); }
+
+  const Type* GetInlineData() const noexcept {
+    return reinterpret_cast<const Type*>(bytes_);
+  }
+
+ private:
+  alignas(Type) unsigned char bytes_[Capacity * sizeof(Type)];
+};
+
+// Empty, so that a SimpleVector without inline elements doesn't grow.
+template <typename Type>
+class InlineBuffer<Type, 0> {
+ protected:
+  Type* GetInlineData() const noexcept { return nullptr; }
+};
+
+// With InlineCapacity > 0, up to that many elements are kept inside the
+// object and the heap is used only past that.
+//
+// Heap storage comes from Allocator, which follows the standard container
+// rules for propagation on copy, move and swap. Elements are constructed
+// and destroyed through allocator_traits, inline ones too, so a std::pmr
+// allocator is passed on to elements that take one. GrowthPolicy picks the
+// capacity to grow to, see growth_policy.h.
+template <typename Type, size_t InlineCapacity = 0,
+          typename Allocator = std::allocator<Type>,
+          typename GrowthPolicy = DoublingGrowth>
+class SimpleVector : private InlineBuffer<Type, InlineCapacity> {
  public:
   using Iterator = Type*;
   using ConstIterator = const Type*;
 
-  SimpleVector() noexcept = default;
+  SimpleVector() noexcept(noexcept(Allocator())) = default;
 
-  SimpleVector(ReserveProxyObj capacity) {
+  explicit SimpleVector(const Allocator& allocator) noexcept
+      : arr_(allocator) {}
+
+  SimpleVector(ReserveProxyObj capacity,
+               const Allocator& allocator = Allocator())
+      : arr_(allocator) {
     Reserve(capacity.GetCapacity());
-    size_ = 0;
   }
 
-  explicit SimpleVector(size_t size)
-      : arr_(size), size_(size), capacity_(size) {
-    std::generate(begin(), end(), []() { return Type(); });
+  explicit SimpleVector(size_t size, const Allocator& allocator = Allocator())
+      : arr_(allocator) {
+    Allocate(size);
+    ValueConstruct(begin(), size);
+    size_ = size;
+  }
+
+  SimpleVector(size_t size, const Type& value,
+               const Allocator& allocator = Allocator())
+      : arr_(allocator) {
+    Allocate(size);
+    FillConstruct(begin(), size, value);
+    size_ = size;
+  }
+
+  SimpleVector(size_t size, ParallelProxyObj parallel,
+               const Allocator& allocator = Allocator())
+      : arr_(allocator) {
+    Allocate(size);
+    ConstructInChunks(begin(), size, parallel,
+                      [this](Iterator first, size_t n) {
+                        ValueConstruct(first, n);
+                      });
+    size_ = size;
+  }
+
+  SimpleVector(size_t size, const Type& value, ParallelProxyObj parallel,
+               const Allocator& allocator = Allocator())
+      : arr_(allocator) {
+    Allocate(size);
+    ConstructInChunks(begin(), size, parallel,
+                      [this, &value](Iterator first, size_t n) {
+                        FillConstruct(first, n, value);
+                      });
+    size_ = size;
+  }
+
+  SimpleVector(std::initializer_list<Type> init,
+               const Allocator& allocator = Allocator())
+      : arr_(allocator) {
+    Allocate(init.size());
+    CopyConstruct(init.begin(), init.end(), begin());
+    size_ = init.size();
   }
 
-  SimpleVector(size_t size, const Type& value) : SimpleVector(size) {
-    std::fill(begin(), end(), value);
+  SimpleVector(const SimpleVector& other)
+      : SimpleVector(other,
+                     AllocatorTraits::select_on_container_copy_construction(
+                         other.GetAllocator())) {}
+
+  SimpleVector(const SimpleVector& other, const Allocator& allocator)
+      : arr_(allocator) {
+    Allocate(other.size_);
+    CopyConstruct(other.begin(), other.end(), begin());
+    size_ = other.size_;
   }
 
-  SimpleVector(std::initializer_list<Type> init)
-      : arr_(init.size()), size_(init.size()), capacity_(init.size()) {
-    std::move(init.begin(), init.end(), begin());
+  // Inline elements can only be moved one by one.
+  SimpleVector(SimpleVector&& rhs) noexcept(IS_NOTHROW_MOVABLE)
+      : arr_(rhs.GetAllocator()) {
+    TakeElements(rhs);
   }
 
-  SimpleVector(const SimpleVector& other) {
-    if (&other != this) {
-      SimpleVector new_arr(other.size_);
-      std::copy(other.begin(), other.end(), new_arr.begin());
-      swap(new_arr);
+  // Takes over the storage of rhs only if allocator can free it.
+  SimpleVector(SimpleVector&& rhs, const Allocator& allocator)
+      : arr_(allocator) {
+    if (allocator == rhs.GetAllocator()) {
+      TakeElements(rhs);
+    } else {
+      Allocate(rhs.size_);
+      CopyConstruct(std::make_move_iterator(rhs.begin()),
+                    std::make_move_iterator(rhs.end()), begin());
+      size_ = rhs.size_;
     }
   }
 
-  SimpleVector(SimpleVector&& rhs)
-      : arr_(std::exchange(rhs.arr_, {})),
-        size_(std::exchange(rhs.size_, 0)),
-        capacity_(std::exchange(rhs.capacity_, 0)) {}
+  ~SimpleVector() { Destroy(begin(), end()); }
 
   SimpleVector& operator=(const SimpleVector& rhs) {
     if (this != &rhs) {
-      SimpleVector tmp(rhs);
-      swap(tmp);
+      SimpleVector tmp(
+          rhs, PROPAGATE_ON_COPY ? rhs.GetAllocator() : GetAllocator());
+      SwapContents(tmp);
     }
     return *this;
   }
 
-  SimpleVector& operator=(SimpleVector&& rhs) {
-    if (this != &rhs) {
-      SimpleVector tmp(std::move(rhs));
-      swap(tmp);
+  // Moves the elements one by one if the allocators differ and don't
+  // propagate.
+  SimpleVector& operator=(SimpleVector&& rhs) noexcept(
+      IS_NOTHROW_MOVABLE &&
+      (PROPAGATE_ON_MOVE || AllocatorTraits::is_always_equal::value)) {
+    if (this == &rhs) {
+      return *this;
+    }
+    if constexpr (!PROPAGATE_ON_MOVE) {
+      if (GetAllocator() != rhs.GetAllocator()) {
+        SimpleVector tmp(std::move(rhs), GetAllocator());
+        SwapContents(tmp);
+        return *this;
+      }
     }
+    if (!rhs.IsInline()) {
+      Destroy(begin(), end());
+      const Storage old_arr(std::move(arr_));
+      arr_ = std::move(rhs.arr_);
+      size_ = std::exchange(rhs.size_, 0);
+      return *this;
+    }
+    Clear();
+    arr_ = Storage(PROPAGATE_ON_MOVE ? rhs.GetAllocator() : GetAllocator());
+    TakeElements(rhs);
     return *this;
   }
 
+  Allocator GetAllocator() const noexcept { return arr_.GetAllocator(); }
+
+  // Grows heap storage in place if the allocator can reallocate it and the
+  // elements are trivially relocatable.
   void Reserve(size_t new_capacity) {
-    if (capacity_ < new_capacity) {
-      ArrayPtr<Type> new_arr(new_capacity);
-      std::move(begin(), end(), new_arr.Get());
-      arr_.swap(new_arr);
-      capacity_ = new_capacity;
+    if (GetCapacity() >= new_capacity) {
+      return;
+    }
+    if constexpr (CAN_REALLOCATE) {
+      if (!IsInline() && arr_.TryReallocate(new_capacity)) {
+        return;
+      }
     }
+    Storage new_arr(new_capacity, GetAllocator());
+    Relocate(begin(), end(), new_arr.Get());
+    ReplaceStorage(new_arr);
   }
 
-  void PushBack(const Type& item) {
-    Iterator it = MakeIterToPushBack();
-    *it = item;
+  // Frees the unused capacity, moving the elements back inline if they
+  // fit there.
+  void ShrinkToFit() {
+    if (IsInline() || size_ == GetCapacity()) {
+      return;
+    }
+    if constexpr (CAN_REALLOCATE) {
+      if (size_ > InlineCapacity && arr_.TryReallocate(size_)) {
+        return;
+      }
+    }
+    Storage new_arr(size_ > InlineCapacity ? size_ : 0, GetAllocator());
+    Relocate(begin(), end(), new_arr ? new_arr.Get() : this->GetInlineData());
+    ReplaceStorage(new_arr);
   }
 
-  void PushBack(Type&& item) {
-    Iterator it = MakeIterToPushBack();
-    *it = std::move(item);
+  // Reserves once if the iterators are at least forward ones. The range may
+  // be part of this vector.
+  template <typename InputIterator>
+  void Append(InputIterator first, InputIterator last) {
+    using Category =
+        typename std::iterator_traits<InputIterator>::iterator_category;
+    if constexpr (!std::is_base_of_v<std::forward_iterator_tag, Category>) {
+      for (; first != last; ++first) {
+        EmplaceBack(*first);
+      }
+    } else {
+      const size_t count = std::distance(first, last);
+      if (size_ + count <= GetCapacity()) {
+        CopyConstruct(first, last, end());
+        size_ += count;
+        return;
+      }
+      Storage new_arr(GetGrownCapacity(size_ + count), GetAllocator());
+      Type* appended = new_arr.Get() + size_;
+      CopyConstruct(first, last, appended);
+      try {
+        Relocate(begin(), end(), new_arr.Get());
+      } catch (...) {
+        Destroy(appended, appended + count);
+        throw;
+      }
+      ReplaceStorage(new_arr);
+      size_ += count;
+    }
   }
 
-  Iterator Insert(ConstIterator position, const Type& value) {
-    assert(position >= begin() && position <= end());
-    if (size_ != capacity_) {
-      std::copy_backward(const_cast<Iterator>(position), end(), end() + 1);
-      arr_[position - arr_.Get()] = value;
-      ++size_;
-      return const_cast<Iterator>(position);
-    } else {
-      auto new_capacity = capacity_ == 0 ? 1 : capacity_ * 2;
-      const auto insert_pos = position - arr_.Get();
-      ArrayPtr<Type> new_vector(new_capacity);
-      std::copy(begin(), const_cast<Iterator>(position), new_vector.Get());
-      new_vector[insert_pos] = value;
-      std::copy(const_cast<Iterator>(position), end(),
-                new_vector.Get() + insert_pos + 1);
-      arr_.swap(new_vector);
+  void PushBack(const Type& item) { EmplaceBack(item); }
+
+  void PushBack(Type&& item) { EmplaceBack(std::move(item)); }
+
+  // Constructs the element in place from args. If it has to reallocate,
+  // the new element is constructed before the old ones are moved, so args
+  // may refer to elements of the vector, and nothing changes if an
+  // exception is thrown.
+  template <typename... Args>
+  Type& EmplaceBack(Args&&... args) {
+    if (size_ < GetCapacity()) {
+      Construct(end(), std::forward<Args>(args)...);
       ++size_;
-      capacity_ = new_capacity;
-      return arr_.Get() + insert_pos;
+      return *(end() - 1);
+    }
+    if constexpr (CAN_REALLOCATE) {
+      return *EmplaceRelocatable(size_, std::forward<Args>(args)...);
     }
+    Storage new_arr(GetGrownCapacity(size_ + 1), GetAllocator());
+    Construct(new_arr.Get() + size_, std::forward<Args>(args)...);
+    try {
+      Relocate(begin(), end(), new_arr.Get());
+    } catch (...) {
+      DestroyAt(new_arr.Get() + size_);
+      throw;
+    }
+    ReplaceStorage(new_arr);
+    ++size_;
+    return *(end() - 1);
   }
-  
+
+  Iterator Insert(ConstIterator position, const Type& value) {
+    return Emplace(position, value);
+  }
+
   Iterator Insert(ConstIterator position, Type&& value) {
+    return Emplace(position, std::move(value));
+  }
+
+  // Shifting elements in place gives only the basic guarantee, as for
+  // std::vector, unless they are trivially relocatable; a reallocating or
+  // appending Emplace gives the strong one.
+  template <typename... Args>
+  Iterator Emplace(ConstIterator position, Args&&... args) {
     assert(position >= begin() && position <= end());
-    if (size_ != capacity_) {
-      std::move_backward(const_cast<Iterator>(position), end(), end() + 1);
-      arr_[position - arr_.Get()] = std::move(value);
-      ++size_;
-      return const_cast<Iterator>(position);
-    } else {
-      auto new_capacity = capacity_ == 0 ? 1 : capacity_ * 2;
-      const auto insert_pos = position - arr_.Get();
-      ArrayPtr<Type> new_vector(new_capacity);
-      std::move(begin(), const_cast<Iterator>(position), new_vector.Get());
-      new_vector[insert_pos] = std::move(value);
-      std::move(const_cast<Iterator>(position), end(),
-                new_vector.Get() + insert_pos + 1);
-      arr_.swap(new_vector);
+    const size_t insert_pos = position - begin();
+    if (insert_pos == size_) {
+      return &EmplaceBack(std::forward<Args>(args)...);
+    }
+    if constexpr (IS_TRIVIALLY_RELOCATABLE) {
+      if (size_ < GetCapacity() || CAN_REALLOCATE) {
+        return EmplaceRelocatable(insert_pos, std::forward<Args>(args)...);
+      }
+    } else if (size_ < GetCapacity()) {
+      Iterator it = begin() + insert_pos;
+      TemporaryElement new_item(*this, std::forward<Args>(args)...);
+      Construct(end(), std::move(*(end() - 1)));
       ++size_;
-      capacity_ = new_capacity;
-      return arr_.Get() + insert_pos;
+      std::move_backward(it, end() - 2, end() - 1);
+      *it = std::move(new_item.Get());
+      return it;
     }
+    Storage new_arr(GetGrownCapacity(size_ + 1), GetAllocator());
+    Type* new_item = new_arr.Get() + insert_pos;
+    Construct(new_item, std::forward<Args>(args)...);
+    try {
+      Relocate(begin(), begin() + insert_pos, new_arr.Get());
+      try {
+        Relocate(begin() + insert_pos, end(), new_item + 1);
+      } catch (...) {
+        Destroy(new_arr.Get(), new_item);
+        throw;
+      }
+    } catch (...) {
+      DestroyAt(new_item);
+      throw;
+    }
+    ReplaceStorage(new_arr);
+    ++size_;
+    return new_item;
   }
 
   void PopBack() noexcept {
     assert(!IsEmpty());
     --size_;
+    DestroyAt(end());
   }
 
   Iterator Erase(ConstIterator pos) { return MakeIterForErase(pos); }
 
   Iterator Erase(Iterator pos) { return MakeIterForErase(pos); }
 
-  void swap(SimpleVector& other) noexcept {
-    arr_.swap(other.arr_);
-    std::swap(size_, other.size_);
-    std::swap(capacity_, other.capacity_);
+  // Allocators are swapped only if they propagate on swap; otherwise they
+  // must be equal, as for standard containers.
+  void swap(SimpleVector& other) noexcept(IS_NOTHROW_MOVABLE) {
+    if constexpr (AllocatorTraits::propagate_on_container_swap::value) {
+      SwapContents(other);
+    } else {
+      assert(GetAllocator() == other.GetAllocator());
+      SwapContents(other);
+      arr_.SwapAllocators(other.arr_);
+    }
   }
 
   size_t GetSize() const noexcept { return size_; }
 
-  size_t GetCapacity() const noexcept { return capacity_; }
+  size_t GetCapacity() const noexcept {
+    return IsInline() ? InlineCapacity : arr_.GetSize();
+  }
 
   bool IsEmpty() const noexcept { return size_ == 0; }
 
   Type& operator[](size_t index) noexcept {
     assert(index <= size_);
-    return arr_[index];
+    return begin()[index];
   }
 
   const Type& operator[](size_t index) const noexcept {
     assert(index <= size_);
-    return arr_[index];
+    return begin()[index];
   }
 
   Type& At(size_t index) {
     if (index >= size_) {
       throw std::out_of_range("Index is out of range");
     }
-    return arr_[index];
+    return begin()[index];
   }
 
   const Type& At(size_t index) const {
     if (index >= size_) {
       throw std::out_of_range("Index is out of range");
     }
-    return arr_[index];
+    return begin()[index];
   }
 
-  void Clear() noexcept { size_ = 0; }
+  void Clear() noexcept {
+    Destroy(begin(), end());
+    size_ = 0;
+  }
 
   void Resize(size_t new_size) {
     if (new_size <= size_) {
-      size_ = new_size;
-      return;
-    } else if (new_size > capacity_) {
-      Reserve(new_size);
-      std::generate(begin() + size_, end(), []() { return Type{}; });
+      Destroy(begin() + new_size, end());
     } else {
-      std::generate(begin() + size_, end() + new_size, []() { return Type{}; });
+      if (new_size > GetCapacity()) {
+        Reserve(GetGrownCapacity(new_size));
+      }
+      ValueConstruct(end(), new_size - size_);
+    }
+    size_ = new_size;
+  }
+
+  void Resize(size_t new_size, ParallelProxyObj parallel) {
+    if (new_size <= size_) {
+      Resize(new_size);
+      return;
+    }
+    if (new_size > GetCapacity()) {
+      Reserve(GetGrownCapacity(new_size));
     }
+    ConstructInChunks(end(), new_size - size_, parallel,
+                      [this](Iterator first, size_t n) {
+                        ValueConstruct(first, n);
+                      });
     size_ = new_size;
   }
 
-  Iterator begin() noexcept { return arr_.Get(); }
+  // Replaces each element with function(element). With several threads,
+  // function is called concurrently. If it throws, the exception is
+  // rethrown once all threads are done, and some elements may be left
+  // untransformed.
+  template <typename Function>
+  void Transform(Function function,
+                 ParallelProxyObj parallel = ParallelProxyObj(1)) {
+    const Iterator data = begin();
+    const auto chunks =
+        RunInChunks(size_, parallel.GetThreadCount(), MIN_PARALLEL_CHUNK_SIZE,
+                    [data, &function](size_t first, size_t last) {
+                      std::transform(data + first, data + last, data + first,
+                                     function);
+                    });
+    for (const Chunk& chunk : chunks) {
+      if (chunk.error) {
+        std::rethrow_exception(chunk.error);
+      }
+    }
+  }
+
+  Iterator begin() noexcept {
+    return IsInline() ? this->GetInlineData() : arr_.Get();
+  }
 
-  Iterator end() noexcept { return arr_.Get() + size_; }
+  Iterator end() noexcept { return begin() + size_; }
 
-  ConstIterator begin() const noexcept { return arr_.Get(); }
+  ConstIterator begin() const noexcept {
+    return IsInline() ? this->GetInlineData() : arr_.Get();
+  }
 
-  ConstIterator end() const noexcept { return arr_.Get() + size_; }
+  ConstIterator end() const noexcept { return begin() + size_; }
 
-  ConstIterator cbegin() const noexcept { return arr_.Get(); }
+  ConstIterator cbegin() const noexcept { return begin(); }
 
-  ConstIterator cend() const noexcept { return arr_.Get() + size_; }
+  ConstIterator cend() const noexcept { return end(); }
 
  private:
-  ArrayPtr<Type> arr_{};
+  using AllocatorTraits = std::allocator_traits<Allocator>;
+  using Storage = ArrayPtr<Type, Allocator>;
+
+  // Empty while the elements are inline.
+  Storage arr_{};
   size_t size_ = 0;
-  size_t capacity_ = 0;
 
-  size_t GetNewCapacity(const size_t& new_size) const {
-    size_t new_capacity =
-        capacity_ != 0 ? new_size > capacity_ ? new_size * 2 : capacity_ : 1;
-    return new_capacity;
+  // Starting a thread costs about as much as writing a megabyte.
+  static constexpr size_t MIN_PARALLEL_CHUNK_SIZE =
+      std::max<size_t>((1 << 20) / sizeof(Type), 1);
+  static constexpr bool IS_TRIVIALLY_RELOCATABLE =
+      IsTriviallyRelocatable<Type>::value;
+  static constexpr bool CAN_REALLOCATE =
+      IS_TRIVIALLY_RELOCATABLE && HasReallocate<Allocator>::value;
+  static constexpr bool USES_ALLOCATOR_CONSTRUCT =
+      HasConstruct<Allocator>::value &&
+      !std::is_same_v<Allocator, std::allocator<Type>>;
+  static constexpr bool PROPAGATE_ON_COPY =
+      AllocatorTraits::propagate_on_container_copy_assignment::value;
+  static constexpr bool PROPAGATE_ON_MOVE =
+      AllocatorTraits::propagate_on_container_move_assignment::value;
+  static constexpr bool IS_NOTHROW_MOVABLE =
+      InlineCapacity == 0 || IS_TRIVIALLY_RELOCATABLE ||
+      std::is_nothrow_move_constructible_v<Type>;
+
+  // Heap storage always holds more than InlineCapacity elements.
+  bool IsInline() const noexcept { return InlineCapacity > 0 && !arr_; }
+
+  // Sets up storage for capacity elements in a vector that has none.
+  void Allocate(size_t capacity) {
+    if (capacity > InlineCapacity) {
+      arr_ = Storage(capacity, GetAllocator());
+    }
   }
 
-  bool IsNotAvailableCapacity(const size_t& new_size) const {
-    return new_size > capacity_;
+  // Moves the elements of rhs into this vector, which must have no storage
+  // of its own, and leaves rhs empty with only its inline storage. The
+  // allocators are exchanged even if the elements are inline, so that they
+  // stay with the allocator that built them.
+  void TakeElements(SimpleVector& rhs) noexcept(IS_NOTHROW_MOVABLE) {
+    if (rhs.IsInline()) {
+      rhs.Relocate(rhs.begin(), rhs.end(), this->GetInlineData());
+      rhs.DestroyRelocated(rhs.begin(), rhs.end());
+    }
+    arr_.swap(rhs.arr_);
+    size_ = std::exchange(rhs.size_, 0);
   }
 
-  Iterator MakeIterToPushBack() {
-    size_t new_size = size_ + 1;
-    size_t new_capacity = GetNewCapacity(new_size);
-    if (IsNotAvailableCapacity(new_size)) {
-      Reserve(new_capacity);
+  // Calls construct(chunk_first, chunk_size) for the chunks of count
+  // elements at first on parallel threads. If any chunk fails, destroys the
+  // others and rethrows. An allocator with its own construct may not be
+  // thread-safe, so its elements are built on one thread.
+  template <typename Construct>
+  void ConstructInChunks(Iterator first, size_t count,
+                         ParallelProxyObj parallel, Construct construct) {
+    const size_t thread_count =
+        USES_ALLOCATOR_CONSTRUCT ? 1 : parallel.GetThreadCount();
+    const auto chunks =
+        RunInChunks(count, thread_count, MIN_PARALLEL_CHUNK_SIZE,
+                    [first, &construct](size_t begin, size_t end) {
+                      construct(first + begin, end - begin);
+                    });
+    const auto failed =
+        std::find_if(chunks.begin(), chunks.end(),
+                     [](const Chunk& chunk) { return chunk.error != nullptr; });
+    if (failed == chunks.end()) {
+      return;
     }
-    size_ = new_size;
-    capacity_ = new_capacity;
-    size_t current_pos = size_ - 1;
-    return Iterator{arr_.Get() + current_pos};
+    for (const Chunk& chunk : chunks) {
+      if (!chunk.error) {
+        Destroy(first + chunk.begin, first + chunk.end);
+      }
+    }
+    std::rethrow_exception(failed->error);
   }
 
-  template <typename Iter>
-  Iterator MakeIterToInsert(Iter pos) {
-    Iterator it = Iterator(pos);
-    auto current_pos = it - begin();
-    size_t new_capacity = GetNewCapacity(size_ + 1);
-    if (IsNotAvailableCapacity(size_ + 1)) {
-      Reserve(new_capacity);
+  // Inserts a trivially relocatable element at position, growing the
+  // storage with Reserve if it is full.
+  template <typename... Args>
+  Iterator EmplaceRelocatable(size_t position, Args&&... args) {
+    // Built aside first, since args may refer to elements that move.
+    alignas(Type) unsigned char new_item[sizeof(Type)];
+    Construct(reinterpret_cast<Type*>(new_item), std::forward<Args>(args)...);
+    if (size_ == GetCapacity()) {
+      try {
+        Reserve(GetGrownCapacity(size_ + 1));
+      } catch (...) {
+        DestroyAt(reinterpret_cast<Type*>(new_item));
+        throw;
+      }
     }
+    Iterator it = begin() + position;
+    std::memmove(static_cast<void*>(it + 1), it,
+                 (size_ - position) * sizeof(Type));
+    std::memcpy(static_cast<void*>(it), new_item, sizeof(Type));
     ++size_;
-    it = begin() + current_pos;
-    std::move_backward(it, end(), end() + 1);
     return it;
   }
 
+  template <typename... Args>
+  void Construct(Type* place, Args&&... args) {
+    AllocatorTraits::construct(arr_.GetAllocator(), place,
+                               std::forward<Args>(args)...);
+  }
+
+  void DestroyAt(Type* place) noexcept {
+    AllocatorTraits::destroy(arr_.GetAllocator(), place);
+  }
+
+  // Like std::uninitialized_copy, but through the allocator.
+  template <typename InputIterator>
+  void CopyConstruct(InputIterator first, InputIterator last, Type* dest) {
+    if constexpr (!USES_ALLOCATOR_CONSTRUCT) {
+      std::uninitialized_copy(first, last, dest);
+    } else {
+      Type* current = dest;
+      try {
+        for (; first != last; ++first, ++current) {
+          Construct(current, *first);
+        }
+      } catch (...) {
+        Destroy(dest, current);
+        throw;
+      }
+    }
+  }
+
+  // Like std::uninitialized_fill_n, but through the allocator.
+  void FillConstruct(Type* dest, size_t count, const Type& value) {
+    if constexpr (!USES_ALLOCATOR_CONSTRUCT) {
+      std::uninitialized_fill_n(dest, count, value);
+    } else {
+      ConstructEach(dest, count, [this, &value](Type* place) {
+        Construct(place, value);
+      });
+    }
+  }
+
+  // Like std::uninitialized_value_construct_n, but through the allocator.
+  void ValueConstruct(Type* dest, size_t count) {
+    if constexpr (!USES_ALLOCATOR_CONSTRUCT) {
+      std::uninitialized_value_construct_n(dest, count);
+    } else {
+      ConstructEach(dest, count, [this](Type* place) { Construct(place); });
+    }
+  }
+
+  // Calls construct(place) for count places from dest. If one throws,
+  // destroys the elements built before it and rethrows.
+  template <typename ConstructOne>
+  void ConstructEach(Type* dest, size_t count, ConstructOne construct) {
+    size_t built = 0;
+    try {
+      for (; built < count; ++built) {
+        construct(dest + built);
+      }
+    } catch (...) {
+      Destroy(dest, dest + built);
+      throw;
+    }
+  }
+
+  // Last to first, like built-in arrays. Elements that own memory then free
+  // it in the reverse order of allocation, which the allocator handles
+  // faster.
+  void Destroy(Iterator first, Iterator last) noexcept {
+    if constexpr (!USES_ALLOCATOR_CONSTRUCT) {
+      std::destroy(std::make_reverse_iterator(last),
+                   std::make_reverse_iterator(first));
+    } else {
+      while (last != first) {
+        DestroyAt(--last);
+      }
+    }
+  }
+
+  // An element built through the allocator of a vector outside its storage.
+  class TemporaryElement {
+   public:
+    template <typename... Args>
+    explicit TemporaryElement(SimpleVector& vector, Args&&... args)
+        : vector_(vector) {
+      vector_.Construct(&Get(), std::forward<Args>(args)...);
+    }
+
+    TemporaryElement(const TemporaryElement&) = delete;
+    TemporaryElement& operator=(const TemporaryElement&) = delete;
+
+    ~TemporaryElement() { vector_.DestroyAt(&Get()); }
+
+    Type& Get() noexcept { return *reinterpret_cast<Type*>(bytes_); }
+
+   private:
+    SimpleVector& vector_;
+    alignas(Type) unsigned char bytes_[sizeof(Type)];
+  };
+
+  // Moves the elements to uninitialized storage at dest when that can't
+  // throw, and copies them otherwise, like std::move_if_noexcept, so that
+  // the source is intact if an exception is thrown. Trivially relocatable
+  // elements are copied bytewise and must not be destroyed afterwards.
+  void Relocate(Iterator first, Iterator last, Type* dest) {
+    if constexpr (IS_TRIVIALLY_RELOCATABLE) {
+      if (first != last) {
+        std::memcpy(static_cast<void*>(dest), first,
+                    (last - first) * sizeof(Type));
+      }
+    } else if constexpr (std::is_nothrow_move_constructible_v<Type> ||
+                         !std::is_copy_constructible_v<Type>) {
+      CopyConstruct(std::make_move_iterator(first),
+                    std::make_move_iterator(last), dest);
+    } else {
+      CopyConstruct(first, last, dest);
+    }
+  }
+
+  // Destroys the sources of Relocate.
+  void DestroyRelocated(Iterator first, Iterator last) noexcept {
+    if constexpr (!IS_TRIVIALLY_RELOCATABLE) {
+      Destroy(first, last);
+    }
+  }
+
+  size_t GetGrownCapacity(size_t required) const noexcept {
+    return GrowthPolicy::GetNewCapacity(GetCapacity(), required, sizeof(Type));
+  }
+
+  // Destroys the elements in the current storage and takes over new_arr,
+  // which already holds them.
+  void ReplaceStorage(Storage& new_arr) noexcept {
+    DestroyRelocated(begin(), end());
+    arr_.swap(new_arr);
+  }
+
+  // Swaps elements, storage and allocators.
+  void SwapContents(SimpleVector& other) noexcept(IS_NOTHROW_MOVABLE) {
+    if (!IsInline() && !other.IsInline()) {
+      arr_.swap(other.arr_);
+      std::swap(size_, other.size_);
+      return;
+    }
+    SimpleVector tmp(std::move(other));
+    other.TakeElements(*this);
+    TakeElements(tmp);
+  }
+
   template <typename Iter>
   Iterator MakeIterForErase(Iter pos) {
-    Iterator it = Iterator(pos);
-    auto current_pos = begin() + std::distance(begin(), it);
-    if (size_ > 0) {
-      std::move(it + 1, end(), current_pos);
+    assert(pos >= begin() && pos < end());
+    Iterator it = begin() + (pos - begin());
+    if constexpr (IS_TRIVIALLY_RELOCATABLE) {
+      DestroyAt(it);
+      std::memmove(static_cast<void*>(it), it + 1,
+                   (end() - it - 1) * sizeof(Type));
       --size_;
+    } else {
+      std::move(it + 1, end(), it);
+      PopBack();
     }
-    return begin() + std::distance(begin(), it);
+    return it;
   }
 };
 
+// Scalars that are equal exactly when their bytes are, like integers,
+// enums and pointers, but not floating-point numbers.
 template <typename Type>
-inline bool operator==(const SimpleVector<Type>& lhs,
-                       const SimpleVector<Type>& rhs) {
-  return (lhs.GetSize() == rhs.GetSize()) &&
-         std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
-}
+inline constexpr bool IS_BITWISE_COMPARABLE =
+    std::is_scalar_v<Type> && std::has_unique_object_representations_v<Type>;
 
+// Index of the first element where lhs and rhs differ, or size. Blocks of
+// elements are skipped with memcmp, which is vectorized.
 template <typename Type>
-inline bool operator!=(const SimpleVector<Type>& lhs,
-                       const SimpleVector<Type>& rhs) {
+size_t FindMismatch(const Type* lhs, const Type* rhs, size_t size) {
+  static_assert(IS_BITWISE_COMPARABLE<Type>);
+  constexpr size_t BLOCK_SIZE = 256 / sizeof(Type);
+  size_t index = 0;
+  while (index + BLOCK_SIZE <= size &&
+         std::memcmp(lhs + index, rhs + index, BLOCK_SIZE * sizeof(Type)) ==
+             0) {
+    index += BLOCK_SIZE;
+  }
+  while (index < size && lhs[index] == rhs[index]) {
+    ++index;
+  }
+  return index;
+}
+
+template <typename Type, size_t N, typename Allocator, typename Growth>
+inline bool operator==(const SimpleVector<Type, N, Allocator, Growth>& lhs,
+                       const SimpleVector<Type, N, Allocator, Growth>& rhs) {
+  if (lhs.GetSize() != rhs.GetSize()) {
+    return false;
+  }
+  if constexpr (IS_BITWISE_COMPARABLE<Type>) {
+    return lhs.IsEmpty() ||
+           std::memcmp(lhs.begin(), rhs.begin(),
+                       lhs.GetSize() * sizeof(Type)) == 0;
+  } else {
+    return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+  }
+}
+
+template <typename Type, size_t N, typename Allocator, typename Growth>
+inline bool operator!=(const SimpleVector<Type, N, Allocator, Growth>& lhs,
+                       const SimpleVector<Type, N, Allocator, Growth>& rhs) {
   return !(lhs == rhs);
 }
 
-template <typename Type>
-inline bool operator<(const SimpleVector<Type>& lhs,
-                      const SimpleVector<Type>& rhs) {
-  return std::lexicographical_compare(
-      lhs.begin(), lhs.end(), rhs.begin(), rhs.end(),
-      [](const auto& lhs, const auto& rhs) { return lhs < rhs; });
+template <typename Type, size_t N, typename Allocator, typename Growth>
+inline bool operator<(const SimpleVector<Type, N, Allocator, Growth>& lhs,
+                      const SimpleVector<Type, N, Allocator, Growth>& rhs) {
+  if constexpr (IS_BITWISE_COMPARABLE<Type>) {
+    const size_t size = std::min(lhs.GetSize(), rhs.GetSize());
+    const size_t index = FindMismatch(lhs.begin(), rhs.begin(), size);
+    return index < size ? lhs[index] < rhs[index]
+                        : lhs.GetSize() < rhs.GetSize();
+  } else {
+    return std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(),
+                                        rhs.end());
+  }
 }
 
-template <typename Type>
-inline bool operator<=(const SimpleVector<Type>& lhs,
-                       const SimpleVector<Type>& rhs) {
+template <typename Type, size_t N, typename Allocator, typename Growth>
+inline bool operator<=(const SimpleVector<Type, N, Allocator, Growth>& lhs,
+                       const SimpleVector<Type, N, Allocator, Growth>& rhs) {
   return !(rhs < lhs);
 }
 
-template <typename Type>
-inline bool operator>(const SimpleVector<Type>& lhs,
-                      const SimpleVector<Type>& rhs) {
+template <typename Type, size_t N, typename Allocator, typename Growth>
+inline bool operator>(const SimpleVector<Type, N, Allocator, Growth>& lhs,
+                      const SimpleVector<Type, N, Allocator, Growth>& rhs) {
   return rhs < lhs;
 }
 
-template <typename Type>
-inline bool operator>=(const SimpleVector<Type>& lhs,
-                       const SimpleVector<Type>& rhs) {
+template <typename Type, size_t N, typename Allocator, typename Growth>
+inline bool operator>=(const SimpleVector<Type, N, Allocator, Growth>& lhs,
+                       const SimpleVector<Type, N, Allocator, Growth>& rhs) {
   return !(lhs < rhs);
-}
\ No newline at end of file
+}
+
+template <typename Type, size_t N, typename Allocator = std::allocator<Type>>
+using SmallVector = SimpleVector<Type, N, Allocator>;
+
+template <typename Type, size_t InlineCapacity = 0>
+using PmrSimpleVector =
+    SimpleVector<Type, InlineCapacity, std::pmr::polymorphic_allocator<Type>>;